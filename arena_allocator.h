@@ -0,0 +1,138 @@
+#pragma once
+#include "array.h"
+
+#include <stddef.h>
+
+// Monotonic allocator for request-scoped data. Allocations are bump-allocated from large
+// blocks and released together by Reset (or when the arena is destroyed). Freeing the most
+// recent allocation rolls the cursor back, and the most recent allocation can be grown in
+// place, so a single growing array doesn't waste the arena.
+class Arena
+{
+public:
+    explicit Arena(size_t blockSize = 64 * 1024)
+        : m_Blocks(nullptr)
+        , m_Cursor(nullptr)
+        , m_End(nullptr)
+        , m_Last(nullptr)
+        , m_BlockSize(blockSize)
+    {
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena()
+    {
+        while (m_Blocks != nullptr)
+        {
+            Block* next = m_Blocks->m_Next;
+            free(m_Blocks);
+            m_Blocks = next;
+        }
+    }
+
+    void* Allocate(size_t bytes, size_t alignment)
+    {
+        char* data = AlignUp(m_Cursor, alignment);
+        // Blocks made for large allocations can end unaligned, so aligning the cursor may
+        // step past m_End.
+        if (m_Cursor == nullptr || data > m_End || bytes > static_cast<size_t>(m_End - data))
+        {
+            AddBlock(bytes + alignment);
+            data = AlignUp(m_Cursor, alignment);
+        }
+        m_Cursor = data + bytes;
+        m_Last = data;
+        return data;
+    }
+
+    // Only the most recent allocation is given back; everything else waits for Reset.
+    void Free(void* data)
+    {
+        if (data != nullptr && data == m_Last)
+        {
+            m_Cursor = m_Last;
+            m_Last = nullptr;
+        }
+    }
+
+    bool TryExpand(void* data, size_t bytes)
+    {
+        if (data == nullptr || data != m_Last || bytes > static_cast<size_t>(m_End - m_Last))
+            return false;
+        m_Cursor = m_Last + bytes;
+        return true;
+    }
+
+    // Releases every allocation. The most recently added block is kept for reuse.
+    void Reset()
+    {
+        if (m_Blocks == nullptr)
+            return;
+        Block* keep = m_Blocks;
+        Block* block = keep->m_Next;
+        while (block != nullptr)
+        {
+            Block* next = block->m_Next;
+            free(block);
+            block = next;
+        }
+        keep->m_Next = nullptr;
+        m_Cursor = keep->Data();
+        m_End = m_Cursor + keep->m_Size;
+        m_Last = nullptr;
+    }
+
+    size_t BlockSize() const { return m_BlockSize; }
+
+private:
+    struct Block
+    {
+        Block* m_Next;
+        size_t m_Size;
+        char* Data() { return reinterpret_cast<char*>(this + 1); }
+    };
+
+    static char* AlignUp(char* pointer, size_t alignment)
+    {
+        uintptr_t value = reinterpret_cast<uintptr_t>(pointer);
+        return reinterpret_cast<char*>((value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+    }
+
+    void AddBlock(size_t minBytes)
+    {
+        size_t size = minBytes > m_BlockSize ? minBytes : m_BlockSize;
+        Block* block = static_cast<Block*>(malloc(sizeof(Block) + size));
+        ASSERT(block != nullptr);
+        block->m_Next = m_Blocks;
+        block->m_Size = size;
+        m_Blocks = block;
+        m_Cursor = block->Data();
+        m_End = m_Cursor + size;
+    }
+
+    Block* m_Blocks;
+    char* m_Cursor;
+    char* m_End;
+    char* m_Last;
+    size_t m_BlockSize;
+};
+
+// Allocator adaptor for BaseArray that allocates from an Arena. The arena must outlive
+// every array using it, and arrays must not be used after the arena is Reset.
+template<typename T>
+class ArenaAllocatorT
+{
+public:
+    explicit ArenaAllocatorT(Arena& arena) : m_Arena(&arena) {}
+    template<typename U>
+    ArenaAllocatorT(const ArenaAllocatorT<U>& other) : m_Arena(other.GetArena()) {}
+
+    T* Allocate(uint32_t numItems) { return static_cast<T*>(m_Arena->Allocate(sizeof(T) * numItems, alignof(T))); }
+    void Free(T* data) { m_Arena->Free(data); }
+    bool TryExpand(T* data, uint32_t numItems) { return m_Arena->TryExpand(data, sizeof(T) * numItems); }
+
+    Arena* GetArena() const { return m_Arena; }
+
+private:
+    Arena* m_Arena;
+};
@@ -5,41 +5,480 @@
 #include <limits>
 #include <malloc.h>
 #include <utility>
+#include <iterator>
+#include <initializer_list>
+#include "array_simd.h"
 
 // Probably a good idea to replace this!
 #define ASSERT(a) do { if (!(a)) { int* x = nullptr; *x = 5; } } while (0)
 
+// Allocators must provide Allocate(numItems) and Free(data), either as static or as
+// member functions; BaseArray stores an instance so allocators can carry state. They
+// may also provide
+//   bool TryExpand(T* data, uint32_t numItems)  - grow the block in place, never moving it
+//   T* Reallocate(T* data, uint32_t numItems)   - realloc semantics, may move the bytes
+//   void OnRelocate(uint32_t numItems)          - told whenever a reallocation moved elements
+//   T* AllocateZeroed(uint32_t numItems)        - Allocate, with the memory zero-filled
+// BaseArray detects these at compile time. TryExpand is used for every element type,
+// Reallocate only for types that are safe to move with memcpy. Without AllocateZeroed,
+// zeroed allocations fall back to Allocate and memset.
 template<typename T>
 struct DefaultAllocatorT
 {
     static T* Allocate(uint32_t numItems) { return static_cast<T*>(malloc(sizeof(T)*numItems)); }
     static void Free(T* data) { free(data); }
+    // glibc realloc extends in place when it can and uses mremap for large mmapped blocks.
+    static T* Reallocate(T* data, uint32_t numItems) { return static_cast<T*>(realloc(static_cast<void*>(data), sizeof(T)*numItems)); }
+    // calloc skips the memset for large blocks, which come straight from mmap already zeroed.
+    static T* AllocateZeroed(uint32_t numItems) { return static_cast<T*>(calloc(numItems, sizeof(T))); }
 };
 
-template<typename CountType, typename ObjectType, typename Allocator, bool IsCopyable = std::is_copy_constructible<ObjectType>::value>
-class BaseArray
+template<typename Allocator, typename T>
+struct AllocatorTraits
 {
+private:
+    template<typename A>
+    static auto HasReallocateImpl(int) -> decltype(std::declval<A&>().Reallocate(std::declval<T*>(), uint32_t()), std::true_type());
+    template<typename A>
+    static std::false_type HasReallocateImpl(...);
+    template<typename A>
+    static auto HasTryExpandImpl(int) -> decltype(std::declval<A&>().TryExpand(std::declval<T*>(), uint32_t()), std::true_type());
+    template<typename A>
+    static std::false_type HasTryExpandImpl(...);
+    template<typename A>
+    static auto HasOnRelocateImpl(int) -> decltype(std::declval<A&>().OnRelocate(uint32_t()), std::true_type());
+    template<typename A>
+    static std::false_type HasOnRelocateImpl(...);
+    template<typename A>
+    static auto HasAllocateZeroedImpl(int) -> decltype(std::declval<A&>().AllocateZeroed(uint32_t()), std::true_type());
+    template<typename A>
+    static std::false_type HasAllocateZeroedImpl(...);
+
+public:
+    typedef decltype(HasReallocateImpl<Allocator>(0)) HasReallocate;
+    typedef decltype(HasTryExpandImpl<Allocator>(0)) HasTryExpand;
+    typedef decltype(HasOnRelocateImpl<Allocator>(0)) HasOnRelocate;
+    typedef decltype(HasAllocateZeroedImpl<Allocator>(0)) HasAllocateZeroed;
+
+    template<typename A = Allocator>
+    static typename std::enable_if<AllocatorTraits<A, T>::HasOnRelocate::value>::type
+        OnRelocate(A& allocator, uint32_t numItems) { allocator.OnRelocate(numItems); }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<!AllocatorTraits<A, T>::HasOnRelocate::value>::type
+        OnRelocate(A&, uint32_t) {}
+
+    template<typename A = Allocator>
+    static typename std::enable_if<AllocatorTraits<A, T>::HasTryExpand::value, bool>::type
+        TryExpand(A& allocator, T* data, uint32_t numItems) { return allocator.TryExpand(data, numItems); }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<!AllocatorTraits<A, T>::HasTryExpand::value, bool>::type
+        TryExpand(A&, T*, uint32_t) { return false; }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<AllocatorTraits<A, T>::HasAllocateZeroed::value, T*>::type
+        AllocateZeroed(A& allocator, uint32_t numItems) { return allocator.AllocateZeroed(numItems); }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<!AllocatorTraits<A, T>::HasAllocateZeroed::value, T*>::type
+        AllocateZeroed(A& allocator, uint32_t numItems)
+    {
+        T* data = allocator.Allocate(numItems);
+        if (data != nullptr)
+            memset(static_cast<void*>(data), 0, numItems * sizeof(T));
+        return data;
+    }
+
+    // Moves an owned block holding usedItems to a block of numItems using memcpy semantics.
+    template<typename A = Allocator>
+    static typename std::enable_if<AllocatorTraits<A, T>::HasReallocate::value, T*>::type
+        Reallocate(A& allocator, T* data, uint32_t /*usedItems*/, uint32_t numItems) { return allocator.Reallocate(data, numItems); }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<!AllocatorTraits<A, T>::HasReallocate::value, T*>::type
+        Reallocate(A& allocator, T* data, uint32_t usedItems, uint32_t numItems)
+    {
+        if (TryExpand(allocator, data, numItems))
+            return data;
+        T* newData = allocator.Allocate(numItems);
+        if (newData == nullptr)
+            return nullptr;
+        memcpy(static_cast<void*>(newData), static_cast<const void*>(data), usedItems * sizeof(T));
+        allocator.Free(data);
+        return newData;
+    }
+};
+
+// The allocator for element type U matching Allocator, for containers that keep arrays
+// of more than one type. An allocator can name it with a nested
+//   template<typename U> struct Rebind { typedef MyAllocatorT<U> Other; };
+// otherwise the first template argument of Allocator is replaced by U. Convert makes the
+// new instance with a converting constructor, as ArenaAllocatorT has, or default
+// constructs it when Allocator is empty.
+template<typename Allocator, typename U>
+struct AllocatorRebindFirstArgument
+{
+};
+
+template<template<typename, typename...> class AllocatorT, typename T, typename... Args, typename U>
+struct AllocatorRebindFirstArgument<AllocatorT<T, Args...>, U>
+{
+    typedef AllocatorT<U, Args...> Other;
+};
+
+template<typename Allocator, typename U>
+struct AllocatorRebind
+{
+private:
+    template<typename A>
+    static typename A::template Rebind<U>::Other RebindImpl(int);
+    template<typename A>
+    static typename AllocatorRebindFirstArgument<A, U>::Other RebindImpl(...);
+
+public:
+    typedef decltype(RebindImpl<Allocator>(0)) Other;
+
+    template<typename A = Allocator>
+    static typename std::enable_if<std::is_constructible<Other, const A&>::value, Other>::type
+        Convert(const A& allocator) { return Other(allocator); }
+
+    template<typename A = Allocator>
+    static typename std::enable_if<!std::is_constructible<Other, const A&>::value, Other>::type
+        Convert(const A&)
+    {
+        static_assert(std::is_empty<A>::value, "Stateful allocators need a converting constructor to be rebound");
+        return Other();
+    }
+};
+
+// Holds the allocator instance of a container. Empty allocators are stored as a base
+// class so that they take up no space.
+template<typename Allocator, bool IsEmpty = std::is_empty<Allocator>::value>
+class AllocatorStorage : private Allocator
+{
+public:
+    AllocatorStorage() {}
+    explicit AllocatorStorage(const Allocator& allocator) : Allocator(allocator) {}
+    Allocator& GetAllocator() { return *this; }
+    const Allocator& GetAllocator() const { return *this; }
+};
+
+template<typename Allocator>
+class AllocatorStorage<Allocator, false>
+{
+public:
+    AllocatorStorage() : m_Allocator() {}
+    explicit AllocatorStorage(const Allocator& allocator) : m_Allocator(allocator) {}
+    Allocator& GetAllocator() { return m_Allocator; }
+    const Allocator& GetAllocator() const { return m_Allocator; }
+private:
+    Allocator m_Allocator;
+};
+
+// Growth policies pick the capacity to allocate when an append runs out of room.
+// NextCapacity receives the current capacity, the minimum capacity required and the
+// element size, and must return a capacity >= required. Any type providing the same
+// static function can be passed as the GrowthPolicy argument of BaseArray.
+struct ExactGrowthPolicy
+{
+    static size_t NextCapacity(size_t /*capacity*/, size_t required, size_t /*elementSize*/) { return required; }
+};
+
+template<size_t Numerator, size_t Denominator, size_t MinCapacity = 4>
+struct GeometricGrowthPolicy
+{
+    static_assert(Numerator > Denominator, "Geometric growth factor must be greater than 1");
+    static size_t NextCapacity(size_t capacity, size_t required, size_t /*elementSize*/)
+    {
+        size_t grown = capacity + (capacity * (Numerator - Denominator)) / Denominator;
+        if (grown < MinCapacity)
+            grown = MinCapacity;
+        return grown > required ? grown : required;
+    }
+};
+
+typedef GeometricGrowthPolicy<3, 2> OneAndHalfGrowthPolicy;
+typedef GeometricGrowthPolicy<2, 1> DoublingGrowthPolicy;
+
+// Rounds whatever Inner asks for up to a whole number of pages, so large buffers don't
+// leave a partially used page at the end of every allocation.
+template<size_t PageSize = 4096, typename Inner = DoublingGrowthPolicy>
+struct PageRoundedGrowthPolicy
+{
+    static size_t NextCapacity(size_t capacity, size_t required, size_t elementSize)
+    {
+        size_t grown = Inner::NextCapacity(capacity, required, elementSize);
+        size_t bytes = (grown * elementSize + PageSize - 1) / PageSize * PageSize;
+        return bytes / elementSize > grown ? bytes / elementSize : grown;
+    }
+};
+
+typedef OneAndHalfGrowthPolicy DefaultGrowthPolicy;
+
+// Check policies decide what the element accessors (operator[], First, Last, Pop and
+// RemoveAt) do about an index out of range or an empty array. Check receives the
+// result of the test.
+//   NoCheckPolicy     - nothing; accessors are a plain load, so indexed loops vectorize
+//   AssertCheckPolicy - ASSERT in every build
+//   DebugCheckPolicy  - ASSERT, unless NDEBUG is defined
+//   TrapCheckPolicy   - always checked, failing with a trap instruction
+// Arrays use DefaultCheckPolicy unless told otherwise, which is AssertCheckPolicy, so
+// Release builds keep their checks, unless ARRAY_CHECK_POLICY names another policy. Hot
+// loops can opt out with NoCheckPolicy or Unchecked().
+struct NoCheckPolicy
+{
+    static void Check(bool) {}
+};
+
+struct AssertCheckPolicy
+{
+    static void Check(bool valid) { ASSERT(valid); }
+};
+
+struct DebugCheckPolicy
+{
+#if defined(NDEBUG)
+    static void Check(bool) {}
+#else
+    static void Check(bool valid) { ASSERT(valid); }
+#endif
+};
+
+struct TrapCheckPolicy
+{
+    static void Check(bool valid)
+    {
+        if (!valid)
+            __builtin_trap();
+    }
+};
+
+#ifndef ARRAY_CHECK_POLICY
+#define ARRAY_CHECK_POLICY AssertCheckPolicy
+#endif
+typedef ARRAY_CHECK_POLICY DefaultCheckPolicy;
+
+// Types whose objects can be moved to a new address with memcpy, without running the
+// move constructor and destructor. Specialize this for element types that have a
+// vtable or own a pointer but don't hold pointers into themselves:
+//   template<> struct IsTriviallyRelocatable<MyType> : std::true_type {};
+template<typename T>
+struct IsTriviallyRelocatable : std::integral_constant<bool,
+    std::is_trivially_move_constructible<T>::value && std::is_trivially_destructible<T>::value>
+{
+};
+
+// Types whose objects are equal exactly when their bytes are equal, so that arrays of them
+// can be compared with memcmp. Floating point types don't qualify (-0.0 == 0.0, NaN).
+// Specialize this for structs without padding whose operator== compares every member:
+//   template<> struct IsBitwiseComparable<MyType> : std::true_type {};
+template<typename T>
+struct IsBitwiseComparable : std::integral_constant<bool,
+    std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value>
+{
+};
+
+// Element range comparisons behind the array comparison operators. Bitwise comparable
+// types are compared a vector at a time instead of element by element.
+template<typename T>
+struct ArrayComparison
+{
+    template<typename U = T>
+    static typename std::enable_if<IsBitwiseComparable<U>::value, bool>::type
+        Equal(const T* a, const T* b, size_t count)
+    {
+        return count == 0 || memcmp(a, b, count * sizeof(T)) == 0;
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!IsBitwiseComparable<U>::value, bool>::type
+        Equal(const T* a, const T* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (a[i] != b[i])
+                return false;
+        }
+        return true;
+    }
+
+    // Negative, zero or positive as a orders before, equal to or after b, judged by the
+    // first element that differs.
+    template<typename U = T>
+    static typename std::enable_if<IsBitwiseComparable<U>::value, int>::type
+        Compare(const T* a, const T* b, size_t count)
+    {
+        const size_t index = count == 0 ? 0 : ArraySimd::MismatchBytes(a, b, count * sizeof(T)) / sizeof(T);
+        if (index == count)
+            return 0;
+        return a[index] < b[index] ? -1 : 1;
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!IsBitwiseComparable<U>::value, int>::type
+        Compare(const T* a, const T* b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (a[i] < b[i])
+                return -1;
+            if (b[i] < a[i])
+                return 1;
+        }
+        return 0;
+    }
+};
+
+// Copying, moving and destroying ranges of objects in raw memory, for the containers
+// built on top of this file. Types that allow it are copied and moved with memcpy and
+// memmove, and not destroyed at all.
+template<typename T>
+struct ObjectRange
+{
+    // Moves count objects from source to the uninitialized memory at dest, leaving source
+    // uninitialized. The ranges may overlap.
+    template<typename U = T>
+    static typename std::enable_if<IsTriviallyRelocatable<U>::value>::type
+        Relocate(T* dest, T* source, size_t count)
+    {
+        if (count > 0)
+            memmove(static_cast<void*>(dest), static_cast<const void*>(source), count * sizeof(T));
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!IsTriviallyRelocatable<U>::value>::type
+        Relocate(T* dest, T* source, size_t count)
+    {
+        if (dest == source)
+            return;
+        if (dest < source)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                new (&dest[i]) T(std::move(source[i]));
+                source[i].~T();
+            }
+        }
+        else
+        {
+            for (size_t i = count; i-- > 0;)
+            {
+                new (&dest[i]) T(std::move(source[i]));
+                source[i].~T();
+            }
+        }
+    }
+
+    // Copy-constructs count objects into the uninitialized memory at dest.
+    template<typename U = T>
+    static typename std::enable_if<std::is_trivially_copyable<U>::value>::type
+        Copy(T* dest, const T* source, size_t count)
+    {
+        if (count > 0)
+            memcpy(static_cast<void*>(dest), static_cast<const void*>(source), count * sizeof(T));
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!std::is_trivially_copyable<U>::value>::type
+        Copy(T* dest, const T* source, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            new (&dest[i]) T(source[i]);
+    }
+
+    // Move-assigns count objects at source to the live objects at dest. The ranges don't
+    // overlap.
+    template<typename U = T>
+    static typename std::enable_if<std::is_trivially_copyable<U>::value>::type
+        MoveAssign(T* dest, T* source, size_t count)
+    {
+        if (count > 0)
+            memcpy(static_cast<void*>(dest), static_cast<const void*>(source), count * sizeof(T));
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!std::is_trivially_copyable<U>::value>::type
+        MoveAssign(T* dest, T* source, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            dest[i] = std::move(source[i]);
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<std::is_trivially_destructible<U>::value>::type
+        Destroy(T*, size_t)
+    {
+    }
+
+    template<typename U = T>
+    static typename std::enable_if<!std::is_trivially_destructible<U>::value>::type
+        Destroy(T* objects, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            objects[i].~T();
+    }
+};
+
+// A view of count contiguous elements owned by some container, for handing a column, a
+// chunk or a segment to a loop. It stays valid until the container reallocates.
+template<typename T>
+class ArraySpan
+{
+public:
+    typedef T* iterator;
+    typedef T* Iterator;
+
+    ArraySpan() : m_Data(nullptr), m_Size(0) {}
+    ArraySpan(T* data, size_t size) : m_Data(data), m_Size(size) {}
+
+    Iterator begin() const { return m_Data; }
+    Iterator end() const { return m_Data + m_Size; }
+    size_t Size() const { return m_Size; }
+    bool Empty() const { return m_Size == 0; }
+    T* GetBuffer() const { return m_Data; }
+    T& operator[](size_t index) const { return m_Data[index]; }
+
+private:
+    T* m_Data;
+    size_t m_Size;
+};
+
+template<typename CountType, typename ObjectType, typename Allocator, typename GrowthPolicy = DefaultGrowthPolicy, typename CheckPolicy = DefaultCheckPolicy, bool IsCopyable = std::is_copy_constructible<ObjectType>::value>
+class BaseArray : private AllocatorStorage<Allocator>
+{
+    typedef AllocatorStorage<Allocator> AllocatorBase;
 public:
     typedef ObjectType* iterator;
     typedef const ObjectType* const_iterator;
     typedef ObjectType* Iterator;
     typedef const ObjectType* ConstIterator;
+    typedef Allocator AllocatorType;
+
+    // Returned by IndexOf when nothing matches. Never a valid index, as capacity is
+    // limited to one less.
+    enum : CountType { INVALID_INDEX = std::numeric_limits<CountType>::max() };
 
     BaseArray()
-        : m_Data(nullptr)
+        : BaseArray(Allocator())
+    {
+    }
+    explicit BaseArray(const Allocator& allocator)
+        : AllocatorBase(allocator)
+        , m_Data(nullptr)
         , m_Size(0)
         , m_Capacity(0)
         , m_OwnsData(true)
         , m_PreserveOrder(false)
     {
     }
-    explicit BaseArray(CountType capacity)
-        : BaseArray()
+    explicit BaseArray(CountType capacity, const Allocator& allocator = Allocator())
+        : BaseArray(allocator)
     {
         Reserve(capacity);
     }
     BaseArray(const BaseArray& other)
-        : BaseArray()
+        : BaseArray(other.GetAllocator())
     {
         Reallocate(other.m_Size);
         CopyFrom(other.m_Data, other.m_Size);
@@ -48,7 +487,7 @@ public:
     }
 
     BaseArray(BaseArray&& other)
-        : BaseArray()
+        : BaseArray(other.GetAllocator())
     {
         if (other.m_OwnsData)
         {
@@ -60,13 +499,15 @@ public:
         else
         {
             Reallocate(other.m_Size);
-            MoveFrom(other.m_Data, other.m_Size);
+            RelocateRange(m_Data, other.m_Data, other.m_Size);
+            m_Size = other.m_Size;
+            other.m_Size = 0;
             m_PreserveOrder = other.m_PreserveOrder;
         }
     }
 
-    BaseArray(ObjectType* data, CountType numElements, CountType maxCapacity, bool ownsData)
-        : BaseArray()
+    BaseArray(ObjectType* data, CountType numElements, CountType maxCapacity, bool ownsData, const Allocator& allocator = Allocator())
+        : BaseArray(allocator)
     {
         m_Data = data;
         m_Size = numElements;
@@ -74,23 +515,60 @@ public:
         m_OwnsData = ownsData;
     }
 
-    BaseArray(std::initializer_list<ObjectType>&& data)
-        : BaseArray()
+    BaseArray(std::initializer_list<ObjectType>&& data, const Allocator& allocator = Allocator())
+        : BaseArray(allocator)
     {
         Reserve(static_cast<CountType>(data.size()));
-        for (auto& object : data)
-        {
-            Push(std::move(object));
-        }
+        Append(data.begin(), static_cast<CountType>(data.size()));
     }
 
     void Push(std::initializer_list<ObjectType>&& data)
     {
-        Reserve(static_cast<CountType>(data.size()) + m_Size);
-        for (auto& obj : data)
+        Append(data.begin(), static_cast<CountType>(data.size()));
+    }
+
+    // Appends copies of count elements starting at data with a single reservation. data
+    // may point into this array.
+    void Append(const ObjectType* data, CountType count)
+    {
+        if (count == 0)
+            return;
+        if (data >= m_Data && data < m_Data + m_Size)
+        {
+            const size_t offset = data - m_Data;
+            GrowTo(static_cast<size_t>(m_Size) + count);
+            data = m_Data + offset;
+        }
+        else
         {
-            Push(std::move(obj));
+            GrowTo(static_cast<size_t>(m_Size) + count);
         }
+        CopyRange(m_Data + m_Size, data, count);
+        m_Size += count;
+    }
+
+    template<typename OtherCountType, typename OtherAllocator, typename OtherGrowthPolicy, typename OtherCheckPolicy, bool OtherIsCopyable>
+    void Append(const BaseArray<OtherCountType, ObjectType, OtherAllocator, OtherGrowthPolicy, OtherCheckPolicy, OtherIsCopyable>& other)
+    {
+        ASSERT(static_cast<size_t>(other.Size()) < static_cast<size_t>(std::numeric_limits<CountType>::max()));
+        Append(other.GetBuffer(), static_cast<CountType>(other.Size()));
+    }
+
+    template<typename Iterator>
+    typename std::enable_if<std::is_pointer<Iterator>::value
+        && std::is_same<typename std::remove_cv<typename std::remove_pointer<Iterator>::type>::type, ObjectType>::value>::type
+        Append(Iterator first, Iterator last)
+    {
+        ASSERT(first <= last);
+        Append(first, static_cast<CountType>(last - first));
+    }
+
+    template<typename Iterator>
+    typename std::enable_if<!std::is_integral<Iterator>::value && !(std::is_pointer<Iterator>::value
+        && std::is_same<typename std::remove_cv<typename std::remove_pointer<Iterator>::type>::type, ObjectType>::value)>::type
+        Append(Iterator first, Iterator last)
+    {
+        AppendRange(first, last, typename std::iterator_traits<Iterator>::iterator_category());
     }
 
     ~BaseArray()
@@ -98,12 +576,14 @@ public:
         Clear();
         if (m_OwnsData)
         {
-            Allocator::Free(m_Data);
+            GetAllocator().Free(m_Data);
         }
     }
 
     BaseArray& operator=(const BaseArray& other)
     {
+        if (this == &other)
+            return *this;
         Clear();
         Reserve(other.m_Size);
         CopyFrom(other.m_Data, other.m_Size);
@@ -113,26 +593,61 @@ public:
 
     BaseArray& operator=(BaseArray&& other)
     {
+        if (this == &other)
+            return *this;
         Clear();
-        if (other.m_OwnsData)
+        if (other.m_OwnsData && m_OwnsData)
         {
             std::swap(m_Flags, other.m_Flags);
             std::swap(m_Data, other.m_Data);
             std::swap(m_Capacity, other.m_Capacity);
             std::swap(m_Size, other.m_Size);
+            std::swap(GetAllocator(), other.GetAllocator());
+        }
+        else if (other.m_OwnsData)
+        {
+            // Our buffer is borrowed so it can't be handed over; take other's instead.
+            m_Data = other.m_Data;
+            m_Capacity = other.m_Capacity;
+            m_Size = other.m_Size;
+            m_Flags = other.m_Flags;
+            GetAllocator() = other.GetAllocator();
+            other.m_Data = nullptr;
+            other.m_Capacity = 0;
+            other.m_Size = 0;
         }
         else
         {
             Reserve(other.m_Size);
-            for (CountType i = 0; i < other.m_Size; ++i)
-            {
-                new (&m_Data[i]) ObjectType(std::move(other.m_Data[i]));
-            }
+            RelocateRange(m_Data, other.m_Data, other.m_Size);
             m_Size = other.m_Size;
+            other.m_Size = 0;
         }
         return *this;
     }
 
+    // Exchanges contents and allocators. Borrowed buffers stay with the array that lent them.
+    void Swap(BaseArray& other)
+    {
+        if (m_OwnsData && other.m_OwnsData)
+        {
+            std::swap(m_Flags, other.m_Flags);
+            std::swap(m_Data, other.m_Data);
+            std::swap(m_Capacity, other.m_Capacity);
+            std::swap(m_Size, other.m_Size);
+            std::swap(GetAllocator(), other.GetAllocator());
+        }
+        else
+        {
+            BaseArray temp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+    }
+
+    Allocator& GetAllocator() { return AllocatorBase::GetAllocator(); }
+    const Allocator& GetAllocator() const { return AllocatorBase::GetAllocator(); }
+
     Iterator begin() { return m_Data; }
     Iterator end() { return m_Data + m_Size; }
     ConstIterator begin() const { return m_Data; }
@@ -175,7 +690,7 @@ public:
         else if (newSize > m_Size)
         {
             auto oldSize = m_Size;
-            Reserve(newSize);
+            GrowTo(newSize);
             for (CountType i = oldSize; i < newSize; ++i)
             {
                 auto& obj = m_Data[i];
@@ -188,20 +703,56 @@ public:
     template<typename U = ObjectType>
     typename std::enable_if<std::is_pod<U>::value, void>::type Resize(CountType newSize)
     {
-        Reserve(newSize);
+        GrowTo(newSize);
+        m_Size = newSize;
+    }
+
+    // Resizes without initializing new elements, for buffers that are about to be filled
+    // by read(), memcpy or a SIMD kernel.
+    template<typename U = ObjectType>
+    void ResizeUninitialized(CountType newSize)
+    {
+        static_assert(std::is_trivial<U>::value, "ResizeUninitialized requires a trivial element type");
+        GrowTo(newSize);
+        m_Size = newSize;
+    }
+
+    // Resizes with new elements set to all-zero bytes. Growing an empty array takes a fresh
+    // zeroed block from the allocator, which for large blocks costs no memset pass at all.
+    template<typename U = ObjectType>
+    void ResizeZeroed(CountType newSize)
+    {
+        static_assert(std::is_trivial<U>::value, "ResizeZeroed requires a trivial element type");
+        if (newSize > m_Capacity && m_Size == 0)
+        {
+            const CountType capacity = NextCapacity(newSize);
+            if (m_OwnsData)
+                GetAllocator().Free(m_Data);
+            m_Data = AllocatorTraits<Allocator, ObjectType>::AllocateZeroed(GetAllocator(), capacity);
+            ASSERT(m_Data != nullptr);
+            m_OwnsData = 1;
+            m_Capacity = capacity;
+        }
+        else if (newSize > m_Size)
+        {
+            GrowTo(newSize);
+            memset(static_cast<void*>(m_Data + m_Size), 0, (newSize - m_Size) * sizeof(ObjectType));
+        }
         m_Size = newSize;
     }
 
-    ObjectType& operator[](CountType index) { ASSERT(index < m_Size); return m_Data[index]; }
-    const ObjectType& operator[](CountType index) const { ASSERT(index < m_Size); return m_Data[index]; }
+    ObjectType& operator[](CountType index) { CheckPolicy::Check(index < m_Size); return m_Data[index]; }
+    const ObjectType& operator[](CountType index) const { CheckPolicy::Check(index < m_Size); return m_Data[index]; }
+    // Never checked, whatever the CheckPolicy.
+    ObjectType& Unchecked(CountType index) { return m_Data[index]; }
+    const ObjectType& Unchecked(CountType index) const { return m_Data[index]; }
     const ObjectType* GetBuffer() const { return m_Data; }
     ObjectType* GetBuffer() { return m_Data; }
 
     template<typename U = ObjectType>
     typename std::enable_if<std::is_pod<U>::value, void>::type Push(const ObjectType& object)
     {
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        GrowTo(m_Size + 1);
         memcpy(&m_Data[m_Size], &object, sizeof(ObjectType));
         ++m_Size;
     }
@@ -209,8 +760,7 @@ public:
     template<typename U = ObjectType>
     typename std::enable_if<!std::is_pod<U>::value, void>::type Push(const ObjectType& object)
     {
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        GrowTo(m_Size + 1);
         new (&m_Data[m_Size]) ObjectType(object);
         ++m_Size;
     }
@@ -218,8 +768,7 @@ public:
     template<typename U = ObjectType>
     typename std::enable_if<!std::is_pod<U>::value, void>::type Push(ObjectType&& object)
     {
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        GrowTo(m_Size + 1);
         new (&m_Data[m_Size]) ObjectType(std::move(object));
         ++m_Size;
     }
@@ -227,102 +776,190 @@ public:
     template<typename U = ObjectType>
     typename std::enable_if<std::is_pod<U>::value, void>::type Pop()
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         --m_Size;
     }
 
     template<typename U = ObjectType>
     typename std::enable_if<!std::is_pod<U>::value, void>::type Pop()
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         m_Data[m_Size - 1].~ObjectType();
         --m_Size;
     }
 
     ObjectType& First()
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         return m_Data[0];
     }
 
     const ObjectType First() const
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         return m_Data[0];
     }
 
     ObjectType& Last()
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         return m_Data[m_Size - 1];
     }
 
     const ObjectType& Last() const
     {
-        ASSERT(m_Size > 0);
+        CheckPolicy::Check(m_Size > 0);
         return m_Data[m_Size - 1];
     }
 
     ObjectType& Grow()
     {
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        GrowTo(m_Size + 1);
         new (&m_Data[m_Size]) ObjectType();
         return m_Data[m_Size++];
     }
 
-    bool Remove(const ObjectType& obj)
+    // Index of the first element equal to value, or INVALID_INDEX. Arithmetic types are
+    // searched with vector compares.
+    CountType IndexOf(const ObjectType& value) const { return FindIndex(value); }
+
+    ObjectType* Find(const ObjectType& value)
+    {
+        const CountType index = FindIndex(value);
+        return index == INVALID_INDEX ? nullptr : &m_Data[index];
+    }
+
+    const ObjectType* Find(const ObjectType& value) const
+    {
+        const CountType index = FindIndex(value);
+        return index == INVALID_INDEX ? nullptr : &m_Data[index];
+    }
+
+    bool Contains(const ObjectType& value) const { return FindIndex(value) != INVALID_INDEX; }
+
+    // Number of elements equal to value.
+    template<typename U = ObjectType>
+    typename std::enable_if<ArraySimd::IsVectorizable<U>::value, CountType>::type
+        Count(const ObjectType& value) const
     {
+        return static_cast<CountType>(ArraySimd::CountEqual(m_Data, m_Size, value));
+    }
+
+    template<typename U = ObjectType>
+    typename std::enable_if<!ArraySimd::IsVectorizable<U>::value, CountType>::type
+        Count(const ObjectType& value) const
+    {
+        CountType found = 0;
         for (CountType i = 0; i < m_Size; ++i)
         {
-            if (m_Data[i] == obj)
-            {
-                RemoveAt(i);
-                return true;
-            }
+            if (m_Data[i] == value)
+                ++found;
         }
-        return false;
+        return found;
+    }
+
+    // Lexicographic three-way comparison: negative, zero or positive as this array orders
+    // before, equal to or after other. Elements are compared with operator< and the
+    // comparison stops at the first that differs.
+    template<typename OtherCountType, typename OtherAllocator, typename OtherGrowthPolicy, typename OtherCheckPolicy, bool OtherIsCopyable>
+    int Compare(const BaseArray<OtherCountType, ObjectType, OtherAllocator, OtherGrowthPolicy, OtherCheckPolicy, OtherIsCopyable>& other) const
+    {
+        const size_t size = m_Size;
+        const size_t otherSize = other.Size();
+        const int result = ArrayComparison<ObjectType>::Compare(m_Data, other.GetBuffer(), size < otherSize ? size : otherSize);
+        if (result != 0)
+            return result;
+        return size < otherSize ? -1 : (size > otherSize ? 1 : 0);
+    }
+
+    bool Remove(const ObjectType& obj)
+    {
+        const CountType index = FindIndex(obj);
+        if (index == INVALID_INDEX)
+            return false;
+        RemoveAt(index);
+        return true;
     }
 
     void RemoveAt(CountType index)
     {
-        ASSERT(index < m_Size);
-        if (!m_PreserveOrder)
+        CheckPolicy::Check(index < m_Size);
+        m_Data[index].~ObjectType();
+        --m_Size;
+        if (index < m_Size)
         {
-            std::swap(m_Data[index], m_Data[--m_Size]);
-        }
-        else
-        {
-            m_Data[index].~ObjectType();
-            for (CountType i = index; i < m_Size - 1; ++i)
-            {
-                m_Data[i] = std::move(m_Data[i + 1]);
-            }
-            --m_Size;
+            if (!m_PreserveOrder)
+                RelocateRange(&m_Data[index], &m_Data[m_Size], 1);
+            else
+                RelocateRange(&m_Data[index], &m_Data[index + 1], m_Size - index);
         }
     }
 
+    // Constructs an element from args directly in the buffer. args must not refer to
+    // elements of this array, since growing may move them.
+    template<typename... Args>
+    ObjectType& Emplace(Args&&... args)
+    {
+        GrowTo(static_cast<size_t>(m_Size) + 1);
+        new (&m_Data[m_Size]) ObjectType(std::forward<Args>(args)...);
+        return m_Data[m_Size++];
+    }
+
+    template<typename... Args>
+    ObjectType& EmplaceAt(CountType index, Args&&... args)
+    {
+        OpenGap(index);
+        new (&m_Data[index]) ObjectType(std::forward<Args>(args)...);
+        ++m_Size;
+        return m_Data[index];
+    }
+
+    // Like Emplace, but returns nullptr instead of asserting when the array can't grow,
+    // either because the allocator failed or because CountType is exhausted. The array is
+    // left unchanged in that case.
+    template<typename... Args>
+    ObjectType* TryEmplace(Args&&... args)
+    {
+        if (!TryGrowTo(static_cast<size_t>(m_Size) + 1))
+            return nullptr;
+        ObjectType* object = new (&m_Data[m_Size]) ObjectType(std::forward<Args>(args)...);
+        ++m_Size;
+        return object;
+    }
+
+    // Removes, in a single pass, every element for which predicate returns true and
+    // returns how many were removed. With preserve order set the remaining elements keep
+    // their order; otherwise holes are filled from the end of the array, as in RemoveAt.
+    template<typename Predicate>
+    CountType RemoveIf(Predicate predicate)
+    {
+        const CountType oldSize = m_Size;
+        m_Size = m_PreserveOrder ? CompactStable(predicate) : CompactUnordered(predicate);
+        return oldSize - m_Size;
+    }
+
+    // Removes every element equal to value, which must not be an element of this array.
+    // Arithmetic types go through a vector kernel that always keeps the order.
     template<typename U = ObjectType>
-    typename std::enable_if<!std::is_pod<U>::value>::type
-        Insert(CountType index, const ObjectType& obj)
+    typename std::enable_if<ArraySimd::IsVectorizable<U>::value, CountType>::type
+        RemoveValues(const ObjectType& value)
     {
-        ASSERT(index <= m_Size);
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        const CountType oldSize = m_Size;
+        m_Size = static_cast<CountType>(ArraySimd::RemoveEqual(m_Data, m_Size, value));
+        return oldSize - m_Size;
+    }
 
-        if (index < m_Size)
-        {
-            new (&m_Data[m_Size]) ObjectType{ std::move(m_Data[m_Size - 1]) };
-            for (CountType i = 1; i < m_Size - index; ++i)
-            {
-                m_Data[m_Size - i] = std::move(m_Data[m_Size - i - 1]);
-            }
-            m_Data[index] = obj;
-        }
-        else
-        {
-            new (&m_Data[m_Size]) ObjectType{ obj };
-        }
+    template<typename U = ObjectType>
+    typename std::enable_if<!ArraySimd::IsVectorizable<U>::value, CountType>::type
+        RemoveValues(const ObjectType& value)
+    {
+        return RemoveIf([&value](const ObjectType& object) { return object == value; });
+    }
+
+    void Insert(CountType index, const ObjectType& obj)
+    {
+        OpenGap(index);
+        new (&m_Data[index]) ObjectType(obj);
         ++m_Size;
     }
 
@@ -330,42 +967,104 @@ public:
     typename std::enable_if<!std::is_pod<U>::value>::type
         Insert(CountType index, ObjectType&& obj)
     {
-        ASSERT(index <= m_Size);
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        OpenGap(index);
+        new (&m_Data[index]) ObjectType(std::move(obj));
+        ++m_Size;
+    }
 
-        if (index < m_Size)
+    // Inserts copies of count elements starting at data before index, shifting the tail
+    // once. data may point into this array.
+    void InsertRange(CountType index, const ObjectType* data, CountType count)
+    {
+        ASSERT(index <= m_Size);
+        if (count == 0)
+            return;
+        if (static_cast<size_t>(m_Size) + count > m_Capacity)
         {
-            new (&m_Data[m_Size]) ObjectType{ std::move(m_Data[m_Size - 1]) };
-            for (CountType i = 1; i < m_Size - index; ++i)
+            // Build the grown buffer around the new range before the old one is freed, so the
+            // source is read while it is still valid wherever it lives, and every element
+            // moves once.
+            const CountType capacity = NextCapacity(static_cast<size_t>(m_Size) + count);
+            ObjectType* newData = GetAllocator().Allocate(capacity);
+            ASSERT(newData != nullptr);
+            CopyRange(&newData[index], data, count);
+            if (m_Data != nullptr)
             {
-                m_Data[m_Size - i] = std::move(m_Data[m_Size - i - 1]);
+                RelocateRange(newData, m_Data, index);
+                RelocateRange(&newData[index + count], &m_Data[index], m_Size - index);
+                AllocatorTraits<Allocator, ObjectType>::OnRelocate(GetAllocator(), m_Size);
+                if (m_OwnsData)
+                    GetAllocator().Free(m_Data);
             }
-            m_Data[index] = std::move(obj);
+            m_Data = newData;
+            m_OwnsData = 1;
+            m_Capacity = capacity;
         }
         else
         {
-            new (&m_Data[m_Size]) ObjectType{ std::move(obj) };
+            // The buffer stays put, but the part of a source inside this array at or after
+            // index moves up with the tail.
+            const bool fromSelf = data >= m_Data && data < m_Data + m_Size;
+            RelocateRange(&m_Data[index + count], &m_Data[index], m_Size - index);
+            if (fromSelf)
+            {
+                const CountType offset = static_cast<CountType>(data - m_Data);
+                const CountType before = offset >= index ? 0 : (index - offset < count ? index - offset : count);
+                CopyRange(&m_Data[index], &m_Data[offset], before);
+                if (before < count)
+                    CopyRange(&m_Data[index + before], &m_Data[offset + before + count], count - before);
+            }
+            else
+            {
+                CopyRange(&m_Data[index], data, count);
+            }
         }
-        ++m_Size;
+        m_Size += count;
     }
 
-    template<typename U = ObjectType>
-    typename std::enable_if<std::is_pod<U>::value>::type
-        Insert(CountType index, const ObjectType& obj)
+    template<typename OtherCountType, typename OtherAllocator, typename OtherGrowthPolicy, typename OtherCheckPolicy, bool OtherIsCopyable>
+    void InsertRange(CountType index, const BaseArray<OtherCountType, ObjectType, OtherAllocator, OtherGrowthPolicy, OtherCheckPolicy, OtherIsCopyable>& other)
     {
-        ASSERT(index <= m_Size);
-        if (m_Size + 1 > m_Capacity)
-            Reallocate(m_Size + 1);
+        ASSERT(static_cast<size_t>(other.Size()) < static_cast<size_t>(std::numeric_limits<CountType>::max()));
+        InsertRange(index, other.GetBuffer(), static_cast<CountType>(other.Size()));
+    }
 
-        if (index < m_Size)
+    // Removes count elements starting at first. With preserve order set the tail slides
+    // down once; otherwise the hole is filled from the end of the array, as in RemoveAt.
+    void RemoveRange(CountType first, CountType count)
+    {
+        ASSERT(first <= m_Size && count <= m_Size - first);
+        if (count == 0)
+            return;
+        ObjectRange<ObjectType>::Destroy(&m_Data[first], count);
+        const CountType tail = m_Size - first - count;
+        if (m_PreserveOrder || tail <= count)
+            RelocateRange(&m_Data[first], &m_Data[first + count], tail);
+        else
+            RelocateRange(&m_Data[first], &m_Data[m_Size - count], count);
+        m_Size -= count;
+    }
+
+    // Releases unused capacity, keeping room for at least capacity elements. Borrowed
+    // buffers are left alone.
+    void ShrinkTo(CountType capacity)
+    {
+        if (capacity < m_Size)
+            capacity = m_Size;
+        if (capacity >= m_Capacity || !m_OwnsData)
+            return;
+        if (capacity == 0)
         {
-            memmove(m_Data + index + 1, m_Data + index, (m_Size - index) * sizeof(ObjectType));
+            GetAllocator().Free(m_Data);
+            m_Data = nullptr;
+            m_Capacity = 0;
+            return;
         }
-        m_Data[index] = obj;
-        ++m_Size;
+        ResizeBuffer(capacity);
     }
 
+    void ShrinkToFit() { ShrinkTo(m_Size); }
+
     bool GetPreserveOrder() const { return m_PreserveOrder; }
     void SetPreserveOrder(bool preserve) { m_PreserveOrder = preserve; }
 
@@ -373,94 +1072,224 @@ public:
     {
         return m_Size == 0;
     }
-private:
-    template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && std::is_trivially_move_constructible<U>::value>::type
-        Reallocate(CountType newSize)
+protected:
+    // Makes room for at least required elements, asking the GrowthPolicy how much to
+    // allocate so that repeated appends reallocate an amortized O(1) number of times.
+    void GrowTo(size_t required)
     {
-        if (newSize <= m_Capacity)
+        if (required <= m_Capacity)
             return;
-        ASSERT(newSize < std::numeric_limits<CountType>::max());
-        auto newData = Allocator::Allocate(newSize);
-        if (m_Data != nullptr)
+        Reallocate(NextCapacity(required));
+    }
+
+    bool TryGrowTo(size_t required)
+    {
+        if (required <= m_Capacity)
+            return true;
+        if (required >= static_cast<size_t>(std::numeric_limits<CountType>::max()))
+            return false;
+        return TryResizeBuffer(NextCapacity(required));
+    }
+
+    CountType NextCapacity(size_t required) const
+    {
+        const size_t maxCapacity = static_cast<size_t>(std::numeric_limits<CountType>::max()) - 1;
+        ASSERT(required <= maxCapacity);
+        size_t newCapacity = GrowthPolicy::NextCapacity(m_Capacity, required, sizeof(ObjectType));
+        if (newCapacity > maxCapacity)
+            newCapacity = maxCapacity;
+        ASSERT(newCapacity >= required);
+        return static_cast<CountType>(newCapacity);
+    }
+
+    void Reallocate(CountType newSize)
+    {
+        if (newSize > m_Capacity)
+            ResizeBuffer(newSize);
+    }
+
+    // Moves the elements to a buffer of exactly newCapacity, which may be smaller than the
+    // current one.
+    void ResizeBuffer(CountType newSize)
+    {
+        const bool resized = TryResizeBuffer(newSize);
+        ASSERT(resized);
+    }
+
+    // Returns false, leaving the array untouched, if the allocator fails.
+    template<typename U = ObjectType>
+    typename std::enable_if<std::is_same<U, ObjectType>::value && IsTriviallyRelocatable<U>::value, bool>::type
+        TryResizeBuffer(CountType newSize)
+    {
+        ASSERT(newSize >= m_Size && newSize < std::numeric_limits<CountType>::max());
+        ObjectType* newData;
+        if (m_Data != nullptr && m_OwnsData)
         {
-            memcpy(newData, m_Data, m_Size * sizeof(ObjectType));
-            if (m_OwnsData)
-                Allocator::Free(m_Data);
+            newData = AllocatorTraits<Allocator, ObjectType>::Reallocate(GetAllocator(), m_Data, m_Size, newSize);
+        }
+        else
+        {
+            newData = GetAllocator().Allocate(newSize);
+            if (newData != nullptr && m_Data != nullptr)
+                memcpy(static_cast<void*>(newData), static_cast<const void*>(m_Data), m_Size * sizeof(ObjectType));
         }
+        if (newData == nullptr)
+            return false;
+        if (newData != m_Data && m_Data != nullptr)
+            AllocatorTraits<Allocator, ObjectType>::OnRelocate(GetAllocator(), m_Size);
         m_Data = newData;
         m_OwnsData = 1;
         m_Capacity = newSize;
+        return true;
     }
 
     template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && !std::is_trivially_move_constructible<U>::value>::type
-        Reallocate(CountType newSize)
+    typename std::enable_if<std::is_same<U, ObjectType>::value && !IsTriviallyRelocatable<U>::value, bool>::type
+        TryResizeBuffer(CountType newSize)
     {
-        if (newSize <= m_Capacity)
-            return;
-        ASSERT(newSize < std::numeric_limits<CountType>::max());
-        auto newData = Allocator::Allocate(newSize);
+        ASSERT(newSize >= m_Size && newSize < std::numeric_limits<CountType>::max());
+        if (m_Data != nullptr && m_OwnsData && AllocatorTraits<Allocator, ObjectType>::TryExpand(GetAllocator(), m_Data, newSize))
+        {
+            m_Capacity = newSize;
+            return true;
+        }
+        auto newData = GetAllocator().Allocate(newSize);
+        if (newData == nullptr)
+            return false;
         if (m_Data != nullptr)
         {
-            for (CountType i = 0; i < m_Size; ++i)
-            {
-                new (&newData[i]) ObjectType(std::move(m_Data[i]));
-            }
+            RelocateRange(newData, m_Data, m_Size);
+            AllocatorTraits<Allocator, ObjectType>::OnRelocate(GetAllocator(), m_Size);
             if (m_OwnsData)
-            {
-                for (CountType i = 0; i < m_Size; ++i)
-                {
-                    m_Data[i].~ObjectType();
-                }
-                Allocator::Free(m_Data);
-            }
-
+                GetAllocator().Free(m_Data);
         }
         m_Data = newData;
         m_OwnsData = 1;
         m_Capacity = newSize;
+        return true;
     }
 
-    void MoveFrom(ObjectType* values, CountType numItems)
+    // Moves numItems objects from source to the uninitialized memory at dest, leaving
+    // source uninitialized. The ranges may overlap.
+    static void RelocateRange(ObjectType* dest, ObjectType* source, size_t numItems)
     {
-        for (CountType i = 0; i < numItems; ++i)
-        {
-            new (&m_Data[i]) ObjectType(std::move(values[i]));
-        }
+        ObjectRange<ObjectType>::Relocate(dest, source, numItems);
+    }
+
+    // Relocates every element of source to the uninitialized memory at dest and leaves
+    // source empty.
+    static void RelocateAll(ObjectType* dest, BaseArray& source)
+    {
+        RelocateRange(dest, source.m_Data, source.m_Size);
+        source.m_Size = 0;
+    }
+
+    // Makes room for count more elements and leaves the slots from index uninitialized.
+    void OpenGap(CountType index, CountType count = 1)
+    {
+        ASSERT(index <= m_Size);
+        GrowTo(static_cast<size_t>(m_Size) + count);
+        RelocateRange(&m_Data[index + count], &m_Data[index], m_Size - index);
     }
 
     template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && std::is_pod<U>::value && std::is_copy_constructible<U>::value, void>::type
-        CopyFrom(const U* values, CountType numItems)
+    typename std::enable_if<ArraySimd::IsVectorizable<U>::value, CountType>::type
+        FindIndex(const ObjectType& value) const
     {
-        memcpy(m_Data, values, numItems * sizeof(U));
+        const size_t index = ArraySimd::FindEqual(m_Data, m_Size, value);
+        return index == m_Size ? static_cast<CountType>(INVALID_INDEX) : static_cast<CountType>(index);
     }
 
     template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && !std::is_pod<U>::value && std::is_copy_constructible<U>::value, void>::type
-        CopyFrom(const U* values, CountType numItems)
+    typename std::enable_if<!ArraySimd::IsVectorizable<U>::value, CountType>::type
+        FindIndex(const ObjectType& value) const
     {
-        for (CountType i = 0; i < numItems; ++i)
+        for (CountType i = 0; i < m_Size; ++i)
         {
-            new (&m_Data[i]) U(values[i]);
+            if (m_Data[i] == value)
+                return i;
         }
+        return INVALID_INDEX;
     }
 
-    template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && std::is_pod<U>::value, void>::type
-        MoveFrom(U* values, CountType numItems)
+    // Destroys the elements matching predicate and slides the others down. Returns the
+    // new size.
+    template<typename Predicate>
+    CountType CompactStable(Predicate& predicate)
     {
-        memcpy(m_Data, values, numItems * sizeof(U));
+        CountType write = 0;
+        while (write < m_Size && !predicate(m_Data[write]))
+            ++write;
+        if (write == m_Size)
+            return write;
+        m_Data[write].~ObjectType();
+        for (CountType read = write + 1; read < m_Size; ++read)
+        {
+            if (predicate(m_Data[read]))
+                m_Data[read].~ObjectType();
+            else
+                RelocateRange(&m_Data[write++], &m_Data[read], 1);
+        }
+        return write;
     }
 
-    template<typename U = ObjectType>
-    typename std::enable_if<std::is_same<U, ObjectType>::value && !std::is_pod<U>::value, void>::type
-        MoveFrom(U* values, CountType numItems)
+    // Destroys the elements matching predicate and fills each hole with the last element
+    // that is kept, so every survivor moves at most once. Returns the new size.
+    template<typename Predicate>
+    CountType CompactUnordered(Predicate& predicate)
     {
-        for (CountType i = 0; i < numItems; ++i)
+        CountType read = 0;
+        CountType end = m_Size;
+        while (read < end)
         {
-            new (&m_Data[i]) U(std::move(values[i]));
+            if (!predicate(m_Data[read]))
+            {
+                ++read;
+                continue;
+            }
+            m_Data[read].~ObjectType();
+            while (--end > read)
+            {
+                if (!predicate(m_Data[end]))
+                    break;
+                m_Data[end].~ObjectType();
+            }
+            if (end > read)
+                RelocateRange(&m_Data[read++], &m_Data[end], 1);
+        }
+        return end;
+    }
+
+    void CopyFrom(const ObjectType* values, CountType numItems)
+    {
+        CopyRange(m_Data, values, numItems);
+    }
+
+    // Copy-constructs numItems objects into the uninitialized memory at dest.
+    static void CopyRange(ObjectType* dest, const ObjectType* source, size_t numItems)
+    {
+        ObjectRange<ObjectType>::Copy(dest, source, numItems);
+    }
+
+    template<typename Iterator>
+    void AppendRange(Iterator first, Iterator last, std::input_iterator_tag)
+    {
+        for (; first != last; ++first)
+        {
+            GrowTo(static_cast<size_t>(m_Size) + 1);
+            new (&m_Data[m_Size]) ObjectType(*first);
+            ++m_Size;
+        }
+    }
+
+    template<typename Iterator>
+    void AppendRange(Iterator first, Iterator last, std::forward_iterator_tag)
+    {
+        GrowTo(static_cast<size_t>(m_Size) + static_cast<size_t>(std::distance(first, last)));
+        for (; first != last; ++first)
+        {
+            new (&m_Data[m_Size]) ObjectType(*first);
+            ++m_Size;
         }
     }
 
@@ -479,10 +1308,10 @@ private:
     };
 };
 
-template<typename CountType, typename ObjectType, typename Allocator>
-class BaseArray<CountType, ObjectType, Allocator, false> : public BaseArray<CountType, ObjectType, Allocator, true>
+template<typename CountType, typename ObjectType, typename Allocator, typename GrowthPolicy, typename CheckPolicy>
+class BaseArray<CountType, ObjectType, Allocator, GrowthPolicy, CheckPolicy, false> : public BaseArray<CountType, ObjectType, Allocator, GrowthPolicy, CheckPolicy, true>
 {
-    using BaseArray<CountType, ObjectType, Allocator, true>::BaseArray;
+    using BaseArray<CountType, ObjectType, Allocator, GrowthPolicy, CheckPolicy, true>::BaseArray;
 public:
     BaseArray() = default;
     BaseArray(const BaseArray&) = delete;
@@ -491,47 +1320,172 @@ public:
     BaseArray& operator=(BaseArray&&) = default;
 };
 
-template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>>
-using Array = BaseArray<uint16_t, ObjectType, Allocator>;
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, typename GrowthPolicy = DefaultGrowthPolicy, typename CheckPolicy = DefaultCheckPolicy>
+using Array = BaseArray<uint16_t, ObjectType, Allocator, GrowthPolicy, CheckPolicy>;
 
-template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>>
-using BigArray = BaseArray<uint32_t, ObjectType, Allocator>;
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, typename GrowthPolicy = DefaultGrowthPolicy, typename CheckPolicy = DefaultCheckPolicy>
+using BigArray = BaseArray<uint32_t, ObjectType, Allocator, GrowthPolicy, CheckPolicy>;
 
-template<typename ObjectType, uint16_t FIXED_SIZE, typename Allocator = DefaultAllocatorT<ObjectType>>
-class InplaceArray : public BaseArray<uint16_t, ObjectType, Allocator>
+template<typename ObjectType, uint16_t FIXED_SIZE, typename Allocator = DefaultAllocatorT<ObjectType>, typename GrowthPolicy = DefaultGrowthPolicy, typename CheckPolicy = DefaultCheckPolicy>
+class InplaceArray : public BaseArray<uint16_t, ObjectType, Allocator, GrowthPolicy, CheckPolicy>
 {
-    typedef BaseArray<uint16_t, ObjectType, Allocator> super;
+    typedef BaseArray<uint16_t, ObjectType, Allocator, GrowthPolicy, CheckPolicy> super;
 public:
     InplaceArray() : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false) {}
-    InplaceArray(const InplaceArray&) = default;
-    InplaceArray(InplaceArray&& other) = default;
+    explicit InplaceArray(const Allocator& allocator) : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false, allocator) {}
+    InplaceArray(const InplaceArray& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false, other.GetAllocator())
+    {
+        CopyFrom(other);
+    }
+    InplaceArray(InplaceArray&& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false, other.GetAllocator())
+    {
+        MoveFrom(other);
+    }
     ~InplaceArray() = default;
-    InplaceArray(const BaseArray<uint16_t, ObjectType, Allocator>& other)
-        : super(other)
+    // Converting construction from any array sharing the count type, including
+    // InplaceArrays of a different FIXED_SIZE.
+    InplaceArray(const super& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false, other.GetAllocator())
+    {
+        CopyFrom(other);
+    }
+    InplaceArray(super&& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), 0, FIXED_SIZE, false, other.GetAllocator())
+    {
+        MoveFrom(other);
+    }
+    InplaceArray& operator=(const InplaceArray& other)
+    {
+        CopyFrom(other);
+        return *this;
+    }
+    InplaceArray& operator=(InplaceArray&& other)
+    {
+        MoveFrom(other);
+        return *this;
+    }
+    InplaceArray& operator=(const super& other)
+    {
+        CopyFrom(other);
+        return *this;
+    }
+    InplaceArray& operator=(super&& other)
     {
+        MoveFrom(other);
+        return *this;
     }
-    InplaceArray& operator=(const InplaceArray&) = default;
-    InplaceArray& operator=(InplaceArray&& other) = default;
+
+    // Moves the elements back into m_FixedBuffer when they fit, otherwise shrinks the
+    // heap buffer.
+    void ShrinkTo(uint16_t capacity)
+    {
+        if (this->m_Size > FIXED_SIZE || capacity > FIXED_SIZE)
+        {
+            super::ShrinkTo(capacity);
+            return;
+        }
+        if (this->m_Data == GetFixedBuffer())
+            return;
+        ObjectType* heapData = this->m_Data;
+        const bool ownsHeapData = this->m_OwnsData;
+        super::RelocateRange(GetFixedBuffer(), heapData, this->m_Size);
+        this->m_Data = GetFixedBuffer();
+        this->m_Capacity = FIXED_SIZE;
+        this->m_OwnsData = false;
+        if (ownsHeapData)
+            this->GetAllocator().Free(heapData);
+    }
+
+    void ShrinkToFit() { ShrinkTo(this->m_Size); }
+
 private:
+    ObjectType* GetFixedBuffer() { return reinterpret_cast<ObjectType*>(&m_FixedBuffer); }
+
+    // Points the array back at m_FixedBuffer, releasing any heap buffer. Must be empty.
+    void UseFixedBuffer()
+    {
+        if (this->m_Data == GetFixedBuffer())
+            return;
+        if (this->m_OwnsData)
+            this->GetAllocator().Free(this->m_Data);
+        this->m_Data = GetFixedBuffer();
+        this->m_Capacity = FIXED_SIZE;
+        this->m_OwnsData = false;
+    }
+
+    void CopyFrom(const super& other)
+    {
+        if (this == &other)
+            return;
+        if (other.Size() <= FIXED_SIZE)
+        {
+            this->Clear();
+            UseFixedBuffer();
+        }
+        super::operator=(other);
+        this->m_PreserveOrder = other.GetPreserveOrder();
+    }
+
+    // Elements that fit are relocated into m_FixedBuffer; larger arrays take over the
+    // source's heap buffer when it has one and only allocate when it doesn't.
+    void MoveFrom(super& other)
+    {
+        if (this == &other)
+            return;
+        this->Clear();
+        const bool preserveOrder = other.GetPreserveOrder();
+        if (other.Size() <= FIXED_SIZE)
+        {
+            UseFixedBuffer();
+            this->m_Size = other.Size();
+            super::RelocateAll(this->m_Data, other);
+        }
+        else
+        {
+            super::operator=(std::move(other));
+        }
+        this->m_PreserveOrder = preserveOrder;
+    }
+
     typename std::aligned_storage<sizeof(ObjectType)*FIXED_SIZE, alignof(ObjectType)>::type m_FixedBuffer;
 };
 
-template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2>
-bool operator==(const BaseArray<CountType1, ObjectType, Allocator1>& a1, const BaseArray<CountType2, ObjectType, Allocator2>& a2)
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator==(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
 {
-    if (a1.Size() != a2.Size())
+    if (static_cast<size_t>(a1.Size()) != static_cast<size_t>(a2.Size()))
         return false;
-    typedef typename std::conditional<sizeof(CountType1) >= sizeof(CountType2), CountType1, CountType2>::type count_t;
-    for (count_t i = 0; i < static_cast<count_t>(a1.Size()); ++i)
-    {
-        if (a1[static_cast<CountType1>(i)] != a2[static_cast<CountType2>(i)])
-            return false;
-    }
-    return true;
+    return ArrayComparison<ObjectType>::Equal(a1.GetBuffer(), a2.GetBuffer(), a1.Size());
 }
 
-template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2>
-bool operator!=(const BaseArray<CountType1, ObjectType, Allocator1>& a1, const BaseArray<CountType2, ObjectType, Allocator2>& a2)
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator!=(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
 {
     return !(a1 == a2);
 }
+
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator<(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
+{
+    return a1.Compare(a2) < 0;
+}
+
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator<=(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
+{
+    return a1.Compare(a2) <= 0;
+}
+
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator>(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
+{
+    return a1.Compare(a2) > 0;
+}
+
+template<typename ObjectType, typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+bool operator>=(const BaseArray<CountType1, ObjectType, Allocator1, Growth1, Check1, Copyable1>& a1, const BaseArray<CountType2, ObjectType, Allocator2, Growth2, Check2, Copyable2>& a2)
+{
+    return a1.Compare(a2) >= 0;
+}
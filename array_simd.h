@@ -0,0 +1,389 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+// Vector kernels behind the bulk operations of BaseArray on arithmetic element types.
+// The instruction set is chosen at compile time from the target flags (__SSE2__,
+// __AVX2__, __AVX512BW__), so build with e.g. -mavx2 to get the wider kernels. Every
+// kernel ends in a scalar loop that also serves targets without SSE2, and all paths
+// compare with operator== semantics: -0.0 equals 0.0 and NaN equals nothing.
+struct ArraySimd
+{
+    // Element types the kernels handle: integers, bool, float and double.
+    template<typename T>
+    struct IsVectorizable : std::integral_constant<bool, std::is_arithmetic<T>::value
+        && (sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)>
+    {
+    };
+
+    // Removes every element equal to value from data[0, count), keeping the order of the
+    // rest, and returns the new count.
+    template<typename T>
+    static size_t RemoveEqual(T* data, size_t count, T value)
+    {
+        static_assert(IsVectorizable<T>::value, "RemoveEqual requires an arithmetic element type");
+        size_t read = 0;
+        size_t write = 0;
+#if defined(__AVX2__)
+        RemoveEqualAvx2(data, count, value, read, write);
+#endif
+#if defined(__SSE2__)
+        RemoveEqualSse2(data, count, value, read, write);
+#endif
+        for (; read < count; ++read)
+        {
+            const T item = data[read];
+            data[write] = item;
+            write += !(item == value);
+        }
+        return write;
+    }
+
+    // Index of the first element of data[0, count) equal to value, or count.
+    template<typename T>
+    static size_t FindEqual(const T* data, size_t count, T value)
+    {
+        static_assert(IsVectorizable<T>::value, "FindEqual requires an arithmetic element type");
+        size_t index = 0;
+#if defined(__AVX512BW__)
+        {
+            const size_t lanes = 64 / sizeof(T);
+            const __m512i needle = Ops<T>::Splat512(value);
+            for (; index + lanes <= count; index += lanes)
+            {
+                const uint64_t matches = Ops<T>::EqualMask512(_mm512_loadu_si512(data + index), needle);
+                if (matches != 0)
+                    return index + __builtin_ctzll(matches);
+            }
+        }
+#endif
+#if defined(__AVX2__)
+        {
+            const size_t lanes = 32 / sizeof(T);
+            const __m256i needle = Ops<T>::Splat256(value);
+            for (; index + lanes <= count; index += lanes)
+            {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+                const uint32_t matches = static_cast<uint32_t>(_mm256_movemask_epi8(Ops<T>::Equal256(block, needle)));
+                if (matches != 0)
+                    return index + __builtin_ctz(matches) / sizeof(T);
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        {
+            const size_t lanes = 16 / sizeof(T);
+            const __m128i needle = Ops<T>::Splat(value);
+            for (; index + lanes <= count; index += lanes)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+                const uint32_t matches = static_cast<uint32_t>(_mm_movemask_epi8(Ops<T>::Equal(block, needle)));
+                if (matches != 0)
+                    return index + __builtin_ctz(matches) / sizeof(T);
+            }
+        }
+#endif
+        for (; index < count; ++index)
+        {
+            if (data[index] == value)
+                return index;
+        }
+        return count;
+    }
+
+    // Number of elements of data[0, count) equal to value.
+    template<typename T>
+    static size_t CountEqual(const T* data, size_t count, T value)
+    {
+        static_assert(IsVectorizable<T>::value, "CountEqual requires an arithmetic element type");
+        size_t index = 0;
+        size_t found = 0;
+#if defined(__AVX512BW__)
+        {
+            const size_t lanes = 64 / sizeof(T);
+            const __m512i needle = Ops<T>::Splat512(value);
+            for (; index + lanes <= count; index += lanes)
+                found += __builtin_popcountll(Ops<T>::EqualMask512(_mm512_loadu_si512(data + index), needle));
+        }
+#endif
+#if defined(__AVX2__)
+        {
+            const size_t lanes = 32 / sizeof(T);
+            const __m256i needle = Ops<T>::Splat256(value);
+            for (; index + lanes <= count; index += lanes)
+            {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+                found += __builtin_popcount(static_cast<uint32_t>(_mm256_movemask_epi8(Ops<T>::Equal256(block, needle)))) / sizeof(T);
+            }
+        }
+#endif
+#if defined(__SSE2__)
+        {
+            const size_t lanes = 16 / sizeof(T);
+            const __m128i needle = Ops<T>::Splat(value);
+            for (; index + lanes <= count; index += lanes)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+                found += __builtin_popcount(static_cast<uint32_t>(_mm_movemask_epi8(Ops<T>::Equal(block, needle)))) / sizeof(T);
+            }
+        }
+#endif
+        for (; index < count; ++index)
+            found += data[index] == value;
+        return found;
+    }
+
+    // Offset of the first byte at which a and b differ, or bytes if they are equal.
+    static size_t MismatchBytes(const void* first, const void* second, size_t bytes)
+    {
+        const uint8_t* a = static_cast<const uint8_t*>(first);
+        const uint8_t* b = static_cast<const uint8_t*>(second);
+        size_t offset = 0;
+#if defined(__AVX512BW__)
+        for (; offset + 64 <= bytes; offset += 64)
+        {
+            const uint64_t differs = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512(a + offset), _mm512_loadu_si512(b + offset));
+            if (differs != 0)
+                return offset + __builtin_ctzll(differs);
+        }
+#endif
+#if defined(__AVX2__)
+        for (; offset + 32 <= bytes; offset += 32)
+        {
+            const __m256i blockA = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + offset));
+            const __m256i blockB = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + offset));
+            const uint32_t differs = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(blockA, blockB)));
+            if (differs != 0)
+                return offset + __builtin_ctz(differs);
+        }
+#endif
+#if defined(__SSE2__)
+        for (; offset + 16 <= bytes; offset += 16)
+        {
+            const __m128i blockA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + offset));
+            const __m128i blockB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + offset));
+            const uint32_t differs = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(blockA, blockB))) & 0xFFFF;
+            if (differs != 0)
+                return offset + __builtin_ctz(differs);
+        }
+#endif
+        for (; offset < bytes; ++offset)
+        {
+            if (a[offset] != b[offset])
+                return offset;
+        }
+        return bytes;
+    }
+
+private:
+#if defined(__SSE2__)
+    // Per element type splat and compare. Compare results have all bits of a lane set
+    // where the lane matched.
+    template<typename T, size_t Size = sizeof(T), bool IsFloat = std::is_floating_point<T>::value>
+    struct Ops;
+
+    // Copies the kept lanes of a 16 or 32 byte block one at a time. byteMask has a bit per
+    // byte of the block, set for the bytes of removed elements. Reads from data never see
+    // earlier writes, as write never passes the element being read.
+    template<typename T>
+    static size_t CompactLanes(T* data, size_t read, size_t write, uint32_t byteMask, size_t lanes)
+    {
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            const T item = data[read + lane];
+            data[write] = item;
+            write += !((byteMask >> (lane * sizeof(T))) & 1);
+        }
+        return write;
+    }
+
+    template<typename T>
+    static void RemoveEqualSse2(T* data, size_t count, T value, size_t& read, size_t& write)
+    {
+        const size_t lanes = 16 / sizeof(T);
+        const __m128i needle = Ops<T>::Splat(value);
+        for (; read + lanes <= count; read += lanes)
+        {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + read));
+            const uint32_t matches = static_cast<uint32_t>(_mm_movemask_epi8(Ops<T>::Equal(block, needle)));
+            if (matches == 0)
+            {
+                // write <= read, so this only overwrites bytes that were already loaded.
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(data + write), block);
+                write += lanes;
+            }
+            else if (matches != 0xFFFF)
+            {
+                write = CompactLanes(data, read, write, matches, lanes);
+            }
+        }
+    }
+#endif
+
+#if defined(__AVX2__)
+    // For each 8 bit mask of dwords to keep, the indices of those dwords packed to the
+    // front, one byte each.
+    static const uint64_t* CompactTable()
+    {
+        static const struct Table
+        {
+            Table()
+            {
+                for (uint32_t mask = 0; mask < 256; ++mask)
+                {
+                    uint64_t entry = 0;
+                    uint32_t packed = 0;
+                    for (uint32_t bit = 0; bit < 8; ++bit)
+                    {
+                        if ((mask >> bit) & 1)
+                            entry |= static_cast<uint64_t>(bit) << (8 * packed++);
+                    }
+                    m_Entries[mask] = entry;
+                }
+            }
+            uint64_t m_Entries[256];
+        } table;
+        return table.m_Entries;
+    }
+
+    template<typename T>
+    static void RemoveEqualAvx2(T* data, size_t count, T value, size_t& read, size_t& write)
+    {
+        const size_t lanes = 32 / sizeof(T);
+        const __m256i needle = Ops<T>::Splat256(value);
+        const uint64_t* table = sizeof(T) >= 4 ? CompactTable() : nullptr;
+        for (; read + lanes <= count; read += lanes)
+        {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + read));
+            const __m256i equal = Ops<T>::Equal256(block, needle);
+            const uint32_t matches = static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+            if (matches == 0)
+            {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + write), block);
+                write += lanes;
+            }
+            else if (matches != 0xFFFFFFFF)
+            {
+                if (sizeof(T) >= 4)
+                {
+                    // Pack the kept dwords to the front with one permute. 8 byte elements
+                    // match or not as pairs of dwords, so the same table serves both.
+                    const uint32_t keep = ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(equal))) & 0xFF;
+                    const __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(table + keep)));
+                    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + write), _mm256_permutevar8x32_epi32(block, indices));
+                    write += __builtin_popcount(keep) * 4 / sizeof(T);
+                }
+                else
+                {
+                    write = CompactLanes(data, read, write, matches, lanes);
+                }
+            }
+        }
+    }
+#endif
+};
+
+#if defined(__SSE2__)
+template<typename T>
+struct ArraySimd::Ops<T, 1, false>
+{
+    static __m128i Splat(T value) { return _mm_set1_epi8(static_cast<char>(value)); }
+    static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+#if defined(__AVX2__)
+    static __m256i Splat256(T value) { return _mm256_set1_epi8(static_cast<char>(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_cmpeq_epi8(a, b); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(T value) { return _mm512_set1_epi8(static_cast<char>(value)); }
+    // One bit per element.
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmpeq_epi8_mask(a, b); }
+#endif
+};
+
+template<typename T>
+struct ArraySimd::Ops<T, 2, false>
+{
+    static __m128i Splat(T value) { return _mm_set1_epi16(static_cast<short>(value)); }
+    static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+#if defined(__AVX2__)
+    static __m256i Splat256(T value) { return _mm256_set1_epi16(static_cast<short>(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_cmpeq_epi16(a, b); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(T value) { return _mm512_set1_epi16(static_cast<short>(value)); }
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmpeq_epi16_mask(a, b); }
+#endif
+};
+
+template<typename T>
+struct ArraySimd::Ops<T, 4, false>
+{
+    static __m128i Splat(T value) { return _mm_set1_epi32(static_cast<int>(value)); }
+    static __m128i Equal(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+#if defined(__AVX2__)
+    static __m256i Splat256(T value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(T value) { return _mm512_set1_epi32(static_cast<int>(value)); }
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmpeq_epi32_mask(a, b); }
+#endif
+};
+
+template<typename T>
+struct ArraySimd::Ops<T, 8, false>
+{
+    static __m128i Splat(T value) { return _mm_set1_epi64x(static_cast<long long>(value)); }
+    // SSE2 has no 64 bit compare: both dword halves have to match.
+    static __m128i Equal(__m128i a, __m128i b)
+    {
+        const __m128i equal = _mm_cmpeq_epi32(a, b);
+        return _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+    }
+#if defined(__AVX2__)
+    static __m256i Splat256(T value) { return _mm256_set1_epi64x(static_cast<long long>(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_cmpeq_epi64(a, b); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(T value) { return _mm512_set1_epi64(static_cast<long long>(value)); }
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmpeq_epi64_mask(a, b); }
+#endif
+};
+
+template<>
+struct ArraySimd::Ops<float, 4, true>
+{
+    static __m128i Splat(float value) { return _mm_castps_si128(_mm_set1_ps(value)); }
+    static __m128i Equal(__m128i a, __m128i b) { return _mm_castps_si128(_mm_cmpeq_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b))); }
+#if defined(__AVX2__)
+    static __m256i Splat256(float value) { return _mm256_castps_si256(_mm256_set1_ps(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_OQ)); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(float value) { return _mm512_castps_si512(_mm512_set1_ps(value)); }
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmp_ps_mask(_mm512_castsi512_ps(a), _mm512_castsi512_ps(b), _CMP_EQ_OQ); }
+#endif
+};
+
+template<>
+struct ArraySimd::Ops<double, 8, true>
+{
+    static __m128i Splat(double value) { return _mm_castpd_si128(_mm_set1_pd(value)); }
+    static __m128i Equal(__m128i a, __m128i b) { return _mm_castpd_si128(_mm_cmpeq_pd(_mm_castsi128_pd(a), _mm_castsi128_pd(b))); }
+#if defined(__AVX2__)
+    static __m256i Splat256(double value) { return _mm256_castpd_si256(_mm256_set1_pd(value)); }
+    static __m256i Equal256(__m256i a, __m256i b) { return _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_OQ)); }
+#endif
+#if defined(__AVX512BW__)
+    static __m512i Splat512(double value) { return _mm512_castpd_si512(_mm512_set1_pd(value)); }
+    static uint64_t EqualMask512(__m512i a, __m512i b) { return _mm512_cmp_pd_mask(_mm512_castsi512_pd(a), _mm512_castsi512_pd(b), _CMP_EQ_OQ); }
+#endif
+};
+#endif
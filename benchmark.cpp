@@ -0,0 +1,1022 @@
+// Micro benchmarks for the containers and allocators. Build with optimizations, e.g.
+//   cmake -DCMAKE_BUILD_TYPE=Release
+// and run custom_array_bench [name filter].
+#include "array.h"
+#include "arena_allocator.h"
+#include "pool_allocator.h"
+#include "huge_page_allocator.h"
+#include "sorted_array.h"
+#include "flat_hash_map.h"
+#include "soa_array.h"
+#include "segmented_array.h"
+#include "ring_array.h"
+#include "slot_map.h"
+#include "sparse_set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+struct BenchmarkEntry
+{
+    const char* m_Name;
+    void (*m_Function)();
+};
+
+static std::vector<BenchmarkEntry>& Benchmarks()
+{
+    static std::vector<BenchmarkEntry> benchmarks;
+    return benchmarks;
+}
+
+struct BenchmarkRegistrar
+{
+    BenchmarkRegistrar(const char* name, void (*function)()) { Benchmarks().push_back(BenchmarkEntry{name, function}); }
+};
+
+#define BENCHMARK(name) \
+    static void name(); \
+    static BenchmarkRegistrar name##Registrar(#name, name); \
+    static void name()
+
+// Keeps the optimizer from discarding a computed value.
+template<typename T>
+static void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs function iterations times per trial and returns the best trial in nanoseconds
+// per iteration.
+template<typename Function>
+static double MeasureNs(Function function, uint32_t iterations, int trials = 5)
+{
+    double best = 0.0;
+    for (int trial = 0; trial < trials; ++trial)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; ++i)
+            function();
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+        if (trial == 0 || ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+static void Report(const char* label, double ns, double baselineNs)
+{
+    printf("  %-40s %12.1f ns  %6.2fx\n", label, ns, baselineNs / ns);
+}
+
+// Small deterministic generator so every run sees the same workload.
+struct Random
+{
+    explicit Random(uint64_t seed) : m_State(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t Next()
+    {
+        m_State ^= m_State << 13;
+        m_State ^= m_State >> 7;
+        m_State ^= m_State << 17;
+        return m_State;
+    }
+    uint32_t Below(uint32_t bound) { return static_cast<uint32_t>(Next() % bound); }
+    uint64_t m_State;
+};
+
+// ---------------------------------------------------------------------------------------
+// Allocators
+
+struct RequestRecord
+{
+    uint64_t m_Id;
+    uint32_t m_Flags;
+    float m_Score;
+};
+
+// Models a request handler: a few dozen temporary arrays of varying sizes are built,
+// read once and all dropped when the request finishes.
+template<typename MakeAllocator>
+static uint64_t HandleRequest(MakeAllocator makeAllocator, uint32_t seed)
+{
+    typedef decltype(makeAllocator(static_cast<uint32_t*>(nullptr))) IdAllocator;
+    typedef decltype(makeAllocator(static_cast<RequestRecord*>(nullptr))) RecordAllocator;
+    Random random(seed);
+    uint64_t checksum = 0;
+    for (int list = 0; list < 24; ++list)
+    {
+        Array<uint32_t, IdAllocator> ids(makeAllocator(static_cast<uint32_t*>(nullptr)));
+        BigArray<RequestRecord, RecordAllocator> records(makeAllocator(static_cast<RequestRecord*>(nullptr)));
+        uint32_t count = 8 + random.Below(256);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            ids.Push(i * 7);
+            records.Push(RequestRecord{i, i & 3, i * 0.5f});
+        }
+        for (uint32_t i = 0; i < count; ++i)
+            checksum += ids[i] + records[i].m_Flags;
+    }
+    return checksum;
+}
+
+struct MakeDefaultAllocator
+{
+    template<typename T>
+    DefaultAllocatorT<T> operator()(T*) const { return DefaultAllocatorT<T>(); }
+};
+
+struct MakeArenaAllocator
+{
+    template<typename T>
+    ArenaAllocatorT<T> operator()(T*) const { return ArenaAllocatorT<T>(*m_Arena); }
+    Arena* m_Arena;
+};
+
+BENCHMARK(ArenaAllocator)
+{
+    const uint32_t requests = 2000;
+    uint32_t seed = 0;
+    double mallocNs = MeasureNs([&]() { DoNotOptimize(HandleRequest(MakeDefaultAllocator(), seed++)); }, requests);
+
+    Arena arena;
+    seed = 0;
+    double arenaNs = MeasureNs([&]()
+    {
+        DoNotOptimize(HandleRequest(MakeArenaAllocator{&arena}, seed++));
+        arena.Reset();
+    }, requests);
+
+    printf("Request with 24 x (Array<uint32_t> + BigArray<Record>), 8-263 pushes each\n");
+    Report("DefaultAllocatorT", mallocNs, mallocNs);
+    Report("ArenaAllocatorT + Reset", arenaNs, mallocNs);
+}
+
+// Each thread repeatedly builds a small Array, fills it and drops it again.
+template<typename Allocator>
+static double SmallArrayThroughput(uint32_t numThreads, uint32_t arraysPerThread)
+{
+    auto work = [arraysPerThread](uint32_t seed)
+    {
+        Random random(seed);
+        uint64_t checksum = 0;
+        for (uint32_t i = 0; i < arraysPerThread; ++i)
+        {
+            Array<uint32_t, Allocator> array;
+            uint32_t count = 1 + random.Below(64);
+            for (uint32_t j = 0; j < count; ++j)
+                array.Push(j);
+            checksum += array.Last();
+        }
+        DoNotOptimize(checksum);
+    };
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < numThreads; ++t)
+        threads.emplace_back(work, t + 1);
+    for (auto& thread : threads)
+        thread.join();
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    return numThreads * static_cast<double>(arraysPerThread) / seconds / 1e6;
+}
+
+BENCHMARK(PoolAllocator)
+{
+    const uint32_t arraysPerThread = 200000;
+    printf("Arrays of 1-64 uint32_t built and destroyed per thread, million arrays/s (%u hardware threads)\n",
+        std::thread::hardware_concurrency());
+    printf("  %8s %18s %18s %8s\n", "threads", "DefaultAllocatorT", "PoolAllocatorT", "speedup");
+    for (uint32_t numThreads = 1; numThreads <= 64; numThreads *= 2)
+    {
+        double mallocRate = SmallArrayThroughput<DefaultAllocatorT<uint32_t>>(numThreads, arraysPerThread);
+        double poolRate = SmallArrayThroughput<PoolAllocatorT<uint32_t>>(numThreads, arraysPerThread);
+        printf("  %8u %18.2f %18.2f %7.2fx\n", numThreads, mallocRate, poolRate, poolRate / mallocRate);
+    }
+}
+
+// Counts data TLB read misses of the calling thread. Reports -1 where performance
+// counters are unavailable, e.g. in most containers and VMs.
+class TlbMissCounter
+{
+public:
+    TlbMissCounter() : m_Fd(-1)
+    {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_Fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~TlbMissCounter()
+    {
+#if defined(__linux__)
+        if (m_Fd >= 0)
+            close(m_Fd);
+#endif
+    }
+    void Start()
+    {
+#if defined(__linux__)
+        if (m_Fd >= 0)
+        {
+            ioctl(m_Fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(m_Fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    int64_t Stop()
+    {
+        int64_t count = -1;
+#if defined(__linux__)
+        if (m_Fd >= 0)
+        {
+            ioctl(m_Fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(m_Fd, &count, sizeof(count)) != sizeof(count))
+                count = -1;
+        }
+#endif
+        return count;
+    }
+private:
+    int m_Fd;
+};
+
+// Memory of this process currently backed by transparent huge pages.
+static long AnonHugePagesMiB()
+{
+    long kib = 0;
+#if defined(__linux__)
+    FILE* file = fopen("/proc/self/smaps_rollup", "r");
+    if (file == nullptr)
+        return -1;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        if (sscanf(line, "AnonHugePages: %ld kB", &kib) == 1)
+            break;
+    }
+    fclose(file);
+#endif
+    return kib / 1024;
+}
+
+template<typename Allocator>
+static void RandomGather(const char* label, uint32_t numElements, uint32_t numGathers)
+{
+    BigArray<float, Allocator> table;
+    table.Resize(numElements);
+    for (uint32_t i = 0; i < numElements; ++i)
+        table[i] = static_cast<float>(i & 1023);
+
+    TlbMissCounter tlbMisses;
+    const float* data = table.GetBuffer();
+    const uint32_t mask = numElements - 1;
+    float sum = 0.0f;
+    tlbMisses.Start();
+    auto start = std::chrono::steady_clock::now();
+    Random random(42);
+    for (uint32_t i = 0; i < numGathers; ++i)
+        sum += data[random.Next() & mask];
+    auto end = std::chrono::steady_clock::now();
+    int64_t misses = tlbMisses.Stop();
+    DoNotOptimize(sum);
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / numGathers;
+    if (misses >= 0)
+        printf("  %-24s %8.2f ns/gather %8.3f dTLB misses/gather %6ld MiB on huge pages\n", label, ns, static_cast<double>(misses) / numGathers, AnonHugePagesMiB());
+    else
+        printf("  %-24s %8.2f ns/gather %8s dTLB misses/gather %6ld MiB on huge pages\n", label, ns, "n/a", AnonHugePagesMiB());
+}
+
+BENCHMARK(HugePageAllocator)
+{
+    const uint32_t numElements = 128u * 1024 * 1024;
+    const uint32_t numGathers = 32u * 1024 * 1024;
+    printf("Random gathers from a 512 MiB BigArray<float>\n");
+    RandomGather<DefaultAllocatorT<float>>("DefaultAllocatorT", numElements, numGathers);
+    RandomGather<HugePageAllocatorT<float>>("HugePageAllocatorT", numElements, numGathers);
+}
+
+// ---------------------------------------------------------------------------------------
+// Arrays
+
+BENCHMARK(ZeroedResize)
+{
+    const uint32_t numElements = 128u * 1024 * 1024;
+    printf("Zero-filled 1 GiB BigArray<uint64_t>, allocate and free\n");
+    double memsetNs = MeasureNs([&]()
+    {
+        BigArray<uint64_t> array;
+        array.Resize(numElements);
+        // Keeps the compiler from turning malloc + memset into calloc.
+        DoNotOptimize(array.GetBuffer());
+        memset(array.GetBuffer(), 0, numElements * sizeof(uint64_t));
+        DoNotOptimize(array.GetBuffer());
+    }, 1, 3);
+    double zeroedNs = MeasureNs([&]()
+    {
+        BigArray<uint64_t> array;
+        array.ResizeZeroed(numElements);
+        DoNotOptimize(array.GetBuffer());
+    }, 1, 3);
+    double hugeNs = MeasureNs([&]()
+    {
+        BigArray<uint64_t, HugePageAllocatorT<uint64_t>> array;
+        array.ResizeZeroed(numElements);
+        DoNotOptimize(array.GetBuffer());
+    }, 1, 3);
+    Report("Resize + memset", memsetNs, memsetNs);
+    Report("ResizeZeroed", zeroedNs, memsetNs);
+    Report("ResizeZeroed, HugePageAllocatorT", hugeNs, memsetNs);
+}
+
+BENCHMARK(RemoveValues)
+{
+    const uint32_t numElements = 1024 * 1024;
+    BigArray<uint32_t> source;
+    Random random(7);
+    for (uint32_t i = 0; i < numElements; ++i)
+        source.Push(random.Below(10));
+    BigArray<uint32_t> array;
+    array.Reserve(numElements);
+    auto refill = [&]()
+    {
+        array.Clear();
+        array.Append(source);
+    };
+    double copyNs = MeasureNs([&]() { refill(); DoNotOptimize(array.Size()); }, 20);
+    double loopNs = MeasureNs([&]()
+    {
+        refill();
+        array.SetPreserveOrder(true);
+        DoNotOptimize(array.RemoveIf([](uint32_t value) { return value == 3; }));
+    }, 20) - copyNs;
+    double simdNs = MeasureNs([&]()
+    {
+        refill();
+        DoNotOptimize(array.RemoveValues(3));
+    }, 20) - copyNs;
+    printf("Remove the ~10%% of elements equal to 3 from a 1M element BigArray<uint32_t>, refill excluded\n");
+    Report("RemoveIf, preserve order", loopNs, loopNs);
+    Report("RemoveValues", simdNs, loopNs);
+}
+
+// What Remove and hand-written lookups did before Contains existed.
+template<typename ArrayType, typename T>
+static bool ScalarContains(const ArrayType& array, const T& value)
+{
+    for (const T& item : array)
+    {
+        if (item == value)
+            return true;
+    }
+    return false;
+}
+
+BENCHMARK(Contains)
+{
+    printf("Contains on an Array<uint32_t> id list, half of the lookups hit\n");
+    for (uint16_t numIds = 16; numIds <= 4096; numIds *= 8)
+    {
+        Array<uint32_t> ids;
+        Random random(numIds);
+        for (uint16_t i = 0; i < numIds; ++i)
+            ids.Push(static_cast<uint32_t>(random.Next()));
+        Array<uint32_t> queries;
+        for (uint16_t i = 0; i < 1024; ++i)
+            queries.Push(i % 2 ? ids[static_cast<uint16_t>(random.Below(numIds))] : static_cast<uint32_t>(random.Next()));
+        double scalarNs = MeasureNs([&]()
+        {
+            uint32_t hits = 0;
+            for (uint32_t query : queries)
+                hits += ScalarContains(ids, query);
+            DoNotOptimize(hits);
+        }, 200) / queries.Size();
+        double simdNs = MeasureNs([&]()
+        {
+            uint32_t hits = 0;
+            for (uint32_t query : queries)
+                hits += ids.Contains(query);
+            DoNotOptimize(hits);
+        }, 200) / queries.Size();
+        char label[64];
+        snprintf(label, sizeof(label), "%u ids, scalar loop", numIds);
+        Report(label, scalarNs, scalarNs);
+        snprintf(label, sizeof(label), "%u ids, Contains", numIds);
+        Report(label, simdNs, scalarNs);
+    }
+}
+
+// The element-wise operator== and a matching lexicographic compare through operator[],
+// as array.h did before.
+template<typename ArrayType>
+static bool IndexedEqual(const ArrayType& a, const ArrayType& b)
+{
+    if (a.Size() != b.Size())
+        return false;
+    for (uint32_t i = 0; i < a.Size(); ++i)
+    {
+        if (a[i] != b[i])
+            return false;
+    }
+    return true;
+}
+
+template<typename ArrayType>
+static int IndexedCompare(const ArrayType& a, const ArrayType& b)
+{
+    const uint32_t common = a.Size() < b.Size() ? a.Size() : b.Size();
+    for (uint32_t i = 0; i < common; ++i)
+    {
+        if (a[i] < b[i])
+            return -1;
+        if (b[i] < a[i])
+            return 1;
+    }
+    return a.Size() < b.Size() ? -1 : (a.Size() > b.Size() ? 1 : 0);
+}
+
+BENCHMARK(Comparison)
+{
+    const uint32_t numElements = 1024 * 1024;
+    BigArray<uint32_t> a;
+    Random random(3);
+    for (uint32_t i = 0; i < numElements; ++i)
+        a.Push(static_cast<uint32_t>(random.Next()));
+    BigArray<uint32_t> b(a);
+    // Differ in the last element so both comparisons read everything.
+    b[numElements - 1] ^= 1;
+
+    printf("Two 1M element BigArray<uint32_t> differing in the last element\n");
+    double indexedEqualNs = MeasureNs([&]() { DoNotOptimize(IndexedEqual(a, b)); }, 50);
+    double equalNs = MeasureNs([&]() { DoNotOptimize(a == b); }, 50);
+    double indexedCompareNs = MeasureNs([&]() { DoNotOptimize(IndexedCompare(a, b)); }, 50);
+    double compareNs = MeasureNs([&]() { DoNotOptimize(a.Compare(b)); }, 50);
+    Report("operator[] loop, ==", indexedEqualNs, indexedEqualNs);
+    Report("operator==", equalNs, indexedEqualNs);
+    Report("operator[] loop, three-way", indexedCompareNs, indexedCompareNs);
+    Report("Compare", compareNs, indexedCompareNs);
+}
+
+// The loop bound only covers a, so the checks on b[i] can't be proven redundant.
+template<typename ArrayType>
+static uint32_t IndexedDot(const ArrayType& a, const ArrayType& b)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < a.Size(); ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+template<typename ArrayType>
+static uint32_t UncheckedDot(const ArrayType& a, const ArrayType& b)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < a.Size(); ++i)
+        sum += a.Unchecked(i) * b.Unchecked(i);
+    return sum;
+}
+
+// With a check in operator[] the loop has an exit in every iteration and stays scalar;
+// without one the compiler vectorizes it.
+BENCHMARK(CheckPolicy)
+{
+    const uint32_t numElements = 64 * 1024;
+    typedef BigArray<uint32_t, DefaultAllocatorT<uint32_t>, DefaultGrowthPolicy, TrapCheckPolicy> TrappingArray;
+    typedef BigArray<uint32_t, DefaultAllocatorT<uint32_t>, DefaultGrowthPolicy, NoCheckPolicy> UncheckedArray;
+    TrappingArray trappingA;
+    TrappingArray trappingB;
+    UncheckedArray uncheckedA;
+    UncheckedArray uncheckedB;
+    for (uint32_t i = 0; i < numElements; ++i)
+    {
+        trappingA.Push(i);
+        trappingB.Push(i * 3);
+        uncheckedA.Push(i);
+        uncheckedB.Push(i * 3);
+    }
+    printf("Indexed dot product of two 64K element BigArray<uint32_t>\n");
+    double trapNs = MeasureNs([&]() { DoNotOptimize(IndexedDot(trappingA, trappingB)); }, 2000);
+    double noCheckNs = MeasureNs([&]() { DoNotOptimize(IndexedDot(uncheckedA, uncheckedB)); }, 2000);
+    double uncheckedNs = MeasureNs([&]() { DoNotOptimize(UncheckedDot(trappingA, trappingB)); }, 2000);
+    Report("operator[], TrapCheckPolicy", trapNs, trapNs);
+    Report("operator[], NoCheckPolicy", noCheckNs, trapNs);
+    Report("Unchecked(), TrapCheckPolicy", uncheckedNs, trapNs);
+}
+
+// Lookups in sets of 10^6 and 10^7 keys, 4 and 40 MB of uint32_t.
+BENCHMARK(SortedLookup)
+{
+    const uint32_t numQueries = 64 * 1024;
+    for (uint32_t numKeys = 1000 * 1000; numKeys <= 10 * 1000 * 1000; numKeys *= 10)
+    {
+        Random random(numKeys);
+        BigArray<uint32_t> keys;
+        for (uint32_t i = 0; i < numKeys; ++i)
+            keys.Push(static_cast<uint32_t>(random.Next()));
+        std::sort(keys.begin(), keys.end());
+        SortedArray<uint32_t> sorted;
+        sorted.Merge(keys);
+        BigArray<uint32_t> queries;
+        for (uint32_t i = 0; i < numQueries; ++i)
+            queries.Push(i % 2 ? sorted[random.Below(sorted.Size())] : static_cast<uint32_t>(random.Next()));
+
+        double stdNs = MeasureNs([&]()
+        {
+            uint32_t hits = 0;
+            for (uint32_t query : queries)
+            {
+                const uint32_t* found = std::lower_bound(sorted.begin(), sorted.end(), query);
+                hits += found != sorted.end() && *found == query;
+            }
+            DoNotOptimize(hits);
+        }, 20) / numQueries;
+        double binaryNs = MeasureNs([&]()
+        {
+            uint32_t hits = 0;
+            for (uint32_t query : queries)
+                hits += sorted.Contains(query);
+            DoNotOptimize(hits);
+        }, 20) / numQueries;
+        sorted.BuildSearchLayout();
+        double layoutNs = MeasureNs([&]()
+        {
+            uint32_t hits = 0;
+            for (uint32_t query : queries)
+                hits += sorted.Contains(query);
+            DoNotOptimize(hits);
+        }, 20) / numQueries;
+        printf("Contains on %u sorted uint32_t keys, half of the lookups hit\n", sorted.Size());
+        Report("std::lower_bound", stdNs, stdNs);
+        Report("Contains, sorted storage", binaryNs, stdNs);
+        Report("Contains, search layout", layoutNs, stdNs);
+    }
+}
+
+BENCHMARK(SortedMerge)
+{
+    const uint32_t numKeys = 1000 * 1000;
+    const uint32_t batchSize = 1000;
+    Random random(12);
+    BigArray<uint32_t> keys;
+    for (uint32_t i = 0; i < numKeys; ++i)
+        keys.Push(static_cast<uint32_t>(random.Next()));
+    std::sort(keys.begin(), keys.end());
+    BigArray<uint32_t> batch;
+    for (uint32_t i = 0; i < batchSize; ++i)
+        batch.Push(static_cast<uint32_t>(random.Next()));
+    std::sort(batch.begin(), batch.end());
+
+    printf("Adding %u sorted keys to a set of %u\n", batchSize, numKeys);
+    double insertNs = MeasureNs([&]()
+    {
+        SortedArray<uint32_t> sorted;
+        sorted.Merge(keys);
+        for (uint32_t key : batch)
+            sorted.Insert(key);
+        DoNotOptimize(sorted.Size());
+    }, 1, 3);
+    double mergeNs = MeasureNs([&]()
+    {
+        SortedArray<uint32_t> sorted;
+        sorted.Merge(keys);
+        sorted.Merge(batch);
+        DoNotOptimize(sorted.Size());
+    }, 1, 3);
+    Report("Insert each", insertNs, insertNs);
+    Report("Merge", mergeNs, insertNs);
+}
+
+// Id to slot lookups: 1M random uint32_t keys mapped to their insertion index.
+BENCHMARK(HashMap)
+{
+    const uint32_t numKeys = 1000 * 1000;
+    const uint32_t numQueries = 64 * 1024;
+    Random random(21);
+    BigArray<uint32_t> keys;
+    BigArray<uint32_t> slots;
+    for (uint32_t i = 0; i < numKeys; ++i)
+    {
+        keys.Push(static_cast<uint32_t>(random.Next()));
+        slots.Push(i);
+    }
+    BigArray<uint32_t> queries;
+    for (uint32_t i = 0; i < numQueries; ++i)
+        queries.Push(i % 2 ? keys[random.Below(numKeys)] : static_cast<uint32_t>(random.Next()));
+
+    printf("Building a map of %u uint32_t keys\n", numKeys);
+    double stdBuildNs = MeasureNs([&]()
+    {
+        std::unordered_map<uint32_t, uint32_t> map;
+        for (uint32_t i = 0; i < numKeys; ++i)
+            map.emplace(keys[i], slots[i]);
+        DoNotOptimize(map.size());
+    }, 1, 3);
+    double stdReservedNs = MeasureNs([&]()
+    {
+        std::unordered_map<uint32_t, uint32_t> map;
+        map.reserve(numKeys);
+        for (uint32_t i = 0; i < numKeys; ++i)
+            map.emplace(keys[i], slots[i]);
+        DoNotOptimize(map.size());
+    }, 1, 3);
+    double flatBuildNs = MeasureNs([&]()
+    {
+        FlatHashMap<uint32_t, uint32_t> map;
+        for (uint32_t i = 0; i < numKeys; ++i)
+            map.Insert(keys[i], slots[i]);
+        DoNotOptimize(map.Size());
+    }, 1, 3);
+    double flatRangeNs = MeasureNs([&]()
+    {
+        FlatHashMap<uint32_t, uint32_t> map;
+        map.InsertRange(keys, slots);
+        DoNotOptimize(map.Size());
+    }, 1, 3);
+    Report("std::unordered_map", stdBuildNs, stdBuildNs);
+    Report("std::unordered_map, reserved", stdReservedNs, stdBuildNs);
+    Report("FlatHashMap", flatBuildNs, stdBuildNs);
+    Report("FlatHashMap, InsertRange", flatRangeNs, stdBuildNs);
+
+    std::unordered_map<uint32_t, uint32_t> stdMap;
+    FlatHashMap<uint32_t, uint32_t> flatMap;
+    for (uint32_t i = 0; i < numKeys; ++i)
+    {
+        stdMap.emplace(keys[i], slots[i]);
+        flatMap.Insert(keys[i], slots[i]);
+    }
+    printf("Lookups, half of them hit\n");
+    double stdFindNs = MeasureNs([&]()
+    {
+        uint32_t sum = 0;
+        for (uint32_t query : queries)
+        {
+            auto found = stdMap.find(query);
+            sum += found == stdMap.end() ? 0 : found->second;
+        }
+        DoNotOptimize(sum);
+    }, 20) / numQueries;
+    double flatFindNs = MeasureNs([&]()
+    {
+        uint32_t sum = 0;
+        for (uint32_t query : queries)
+        {
+            const uint32_t* found = flatMap.Find(query);
+            sum += found == nullptr ? 0 : *found;
+        }
+        DoNotOptimize(sum);
+    }, 20) / numQueries;
+    Report("std::unordered_map::find", stdFindNs, stdFindNs);
+    Report("FlatHashMap::Find", flatFindNs, stdFindNs);
+}
+
+// Appending particle rows: four parallel BigArrays kept in sync by hand against one
+// SoaArray with the same columns.
+BENCHMARK(SoaPush)
+{
+    const uint32_t numRows = 1024 * 1024;
+    printf("Pushing %u rows of x, y, z and id\n", numRows);
+    double parallelNs = MeasureNs([&]()
+    {
+        BigArray<float> x;
+        BigArray<float> y;
+        BigArray<float> z;
+        BigArray<uint32_t> id;
+        for (uint32_t i = 0; i < numRows; ++i)
+        {
+            x.Push(static_cast<float>(i));
+            y.Push(static_cast<float>(i));
+            z.Push(static_cast<float>(i));
+            id.Push(i);
+        }
+        DoNotOptimize(x.GetBuffer());
+        DoNotOptimize(y.GetBuffer());
+        DoNotOptimize(z.GetBuffer());
+        DoNotOptimize(id.GetBuffer());
+    }, 5) / numRows;
+    double soaNs = MeasureNs([&]()
+    {
+        BigSoaArray<float, float, float, uint32_t> particles;
+        for (uint32_t i = 0; i < numRows; ++i)
+            particles.Push(static_cast<float>(i), static_cast<float>(i), static_cast<float>(i), i);
+        DoNotOptimize(particles.Column<0>().GetBuffer());
+    }, 5) / numRows;
+    Report("four BigArrays", parallelNs, parallelNs);
+    Report("SoaArray", soaNs, parallelNs);
+}
+
+BENCHMARK(SegmentedPush)
+{
+    const uint32_t numElements = 16 * 1024 * 1024;
+    printf("Pushing %u elements, then summing them\n", numElements);
+    double bigNs = MeasureNs([&]()
+    {
+        BigArray<uint64_t> array;
+        for (uint32_t i = 0; i < numElements; ++i)
+            array.Push(i);
+        DoNotOptimize(array.GetBuffer());
+    }, 3) / numElements;
+    double fixedNs = MeasureNs([&]()
+    {
+        SegmentedArray<uint64_t> array;
+        for (uint32_t i = 0; i < numElements; ++i)
+            array.Push(i);
+        DoNotOptimize(&array.First());
+    }, 3) / numElements;
+    double geometricNs = MeasureNs([&]()
+    {
+        SegmentedArray<uint64_t, DefaultAllocatorT<uint64_t>, GeometricChunkPolicy<>> array;
+        for (uint32_t i = 0; i < numElements; ++i)
+            array.Push(i);
+        DoNotOptimize(&array.First());
+    }, 3) / numElements;
+    Report("push BigArray", bigNs, bigNs);
+    Report("push SegmentedArray fixed", fixedNs, bigNs);
+    Report("push SegmentedArray geometric", geometricNs, bigNs);
+
+    BigArray<uint64_t> big;
+    SegmentedArray<uint64_t> segmented;
+    for (uint32_t i = 0; i < numElements; ++i)
+    {
+        big.Push(i);
+        segmented.Push(i);
+    }
+    double bigSumNs = MeasureNs([&]()
+    {
+        uint64_t sum = 0;
+        for (uint64_t value : big)
+            sum += value;
+        DoNotOptimize(sum);
+    }, 5) / numElements;
+    double indexSumNs = MeasureNs([&]()
+    {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < segmented.Size(); ++i)
+            sum += segmented[i];
+        DoNotOptimize(sum);
+    }, 5) / numElements;
+    double chunkSumNs = MeasureNs([&]()
+    {
+        uint64_t sum = 0;
+        for (uint32_t chunk = 0; chunk < segmented.ChunkCount(); ++chunk)
+        {
+            for (uint64_t value : segmented.Chunk(chunk))
+                sum += value;
+        }
+        DoNotOptimize(sum);
+    }, 5) / numElements;
+    Report("sum BigArray", bigSumNs, bigSumNs);
+    Report("sum SegmentedArray by index", indexSumNs, bigSumNs);
+    Report("sum SegmentedArray by chunk", chunkSumNs, bigSumNs);
+}
+
+BENCHMARK(RingFifo)
+{
+    const uint32_t queueLength = 4096;
+    const uint32_t numEvents = 1024 * 1024;
+    const uint32_t batch = 64;
+    printf("Streaming %u events through a queue holding %u\n", numEvents, queueLength);
+    double arrayNs = MeasureNs([&]()
+    {
+        BigArray<uint64_t> queue;
+        queue.SetPreserveOrder(true);
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < queueLength; ++i)
+            queue.Push(i);
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            sum += queue[0];
+            queue.RemoveAt(0);
+            queue.Push(i);
+        }
+        DoNotOptimize(sum);
+    }, 3) / numEvents;
+    double ringNs = MeasureNs([&]()
+    {
+        RingArray<uint64_t> queue;
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < queueLength; ++i)
+            queue.PushBack(i);
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            sum += queue.First();
+            queue.PopFront();
+            queue.PushBack(i);
+        }
+        DoNotOptimize(sum);
+    }, 3) / numEvents;
+    double bulkNs = MeasureNs([&]()
+    {
+        RingArray<uint64_t> queue;
+        uint64_t events[batch];
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < queueLength; ++i)
+            queue.PushBack(i);
+        for (uint32_t i = 0; i < numEvents; i += batch)
+        {
+            queue.PopFront(events, batch);
+            for (uint32_t j = 0; j < batch; ++j)
+            {
+                sum += events[j];
+                events[j] = i + j;
+            }
+            queue.PushBack(events, batch);
+        }
+        DoNotOptimize(sum);
+    }, 3) / numEvents;
+    Report("BigArray RemoveAt(0)", arrayNs, arrayNs);
+    Report("RingArray", ringNs, arrayNs);
+    Report("RingArray in batches of 64", bulkNs, arrayNs);
+}
+
+BENCHMARK(SlotMapChurn)
+{
+    struct Component
+    {
+        float m_Position[3];
+        uint32_t m_Id;
+    };
+    const uint32_t numLive = 100000;
+    const uint32_t numOps = 1000000;
+    printf("Removing, adding and looking up components among %u live ones\n", numLive);
+    double mapNs = MeasureNs([&]()
+    {
+        BigArray<Component> components;
+        std::unordered_map<uint32_t, uint32_t> indexOfId;
+        uint32_t nextId = 0;
+        for (; nextId < numLive; ++nextId)
+        {
+            indexOfId[nextId] = components.Size();
+            components.Push(Component{{0, 0, 0}, nextId});
+        }
+        Random random(1);
+        float sum = 0;
+        for (uint32_t i = 0; i < numOps; ++i)
+        {
+            // Remove a random component, swapping the last one into its place.
+            const uint32_t index = random.Below(components.Size());
+            indexOfId.erase(components[index].m_Id);
+            components.RemoveAt(index);
+            if (index < components.Size())
+                indexOfId[components[index].m_Id] = index;
+            indexOfId[nextId] = components.Size();
+            components.Push(Component{{1, 2, 3}, nextId++});
+            // Look up a recent id, which may have been removed since.
+            auto found = indexOfId.find(nextId - 1 - random.Below(numLive / 2));
+            if (found != indexOfId.end())
+                sum += components[found->second].m_Position[1];
+        }
+        DoNotOptimize(sum);
+    }, 3) / numOps;
+    double slotNs = MeasureNs([&]()
+    {
+        SlotMap<Component> components;
+        BigArray<SlotMapHandle> handles;
+        uint32_t nextId = 0;
+        for (; nextId < numLive; ++nextId)
+            handles.Push(components.Insert(Component{{0, 0, 0}, nextId}));
+        Random random(1);
+        float sum = 0;
+        for (uint32_t i = 0; i < numOps; ++i)
+        {
+            const uint32_t index = random.Below(components.Size());
+            components.Remove(components.HandleAt(index));
+            handles.Push(components.Insert(Component{{1, 2, 3}, nextId++}));
+            const Component* found = components.Find(handles[nextId - 1 - random.Below(numLive / 2)]);
+            if (found != nullptr)
+                sum += found->m_Position[1];
+        }
+        DoNotOptimize(sum);
+    }, 3) / numOps;
+    Report("BigArray + unordered_map", mapNs, mapNs);
+    Report("SlotMap", slotNs, mapNs);
+}
+
+BENCHMARK(SparseSetLookup)
+{
+    const uint32_t idRange = 50 * 1000 * 1000;
+    const uint32_t numIds = 20000;
+    const uint32_t numLookups = 4 * 1024 * 1024;
+    printf("%u live ids in runs of 100 out of %u, %u lookups, then intersecting two such sets\n", numIds, idRange, numLookups);
+    Random random(3);
+    BigArray<uint32_t> ids;
+    // Live ids come in runs, the way entity ids handed out together stay alive together.
+    for (uint32_t i = 0; i < numIds; i += 100)
+    {
+        const uint32_t first = random.Below(idRange - 100);
+        for (uint32_t j = 0; j < 100; ++j)
+            ids.Push(first + j);
+    }
+    BigArray<uint32_t> probes;
+    for (uint32_t i = 0; i < numLookups; ++i)
+        probes.Push(i % 2 == 0 ? ids[random.Below(numIds)] : random.Below(idRange));
+
+    std::unordered_map<uint32_t, float> unordered;
+    FlatHashMap<uint32_t, float> flat;
+    SparseSet<float> sparse;
+    for (uint32_t id : ids)
+    {
+        unordered.emplace(id, 1.0f);
+        flat.Insert(id, 1.0f);
+        sparse.Insert(id, 1.0f);
+    }
+    printf("  sparse set pages: %u of %u, %u KB\n", sparse.PageCount(), (idRange >> 12) + 1, sparse.PageCount() * 16);
+
+    double unorderedNs = MeasureNs([&]()
+    {
+        float sum = 0;
+        for (uint32_t id : probes)
+        {
+            auto found = unordered.find(id);
+            if (found != unordered.end())
+                sum += found->second;
+        }
+        DoNotOptimize(sum);
+    }, 5) / numLookups;
+    double flatNs = MeasureNs([&]()
+    {
+        float sum = 0;
+        for (uint32_t id : probes)
+        {
+            const float* found = flat.Find(id);
+            if (found != nullptr)
+                sum += *found;
+        }
+        DoNotOptimize(sum);
+    }, 5) / numLookups;
+    double sparseNs = MeasureNs([&]()
+    {
+        float sum = 0;
+        for (uint32_t id : probes)
+        {
+            const float* found = sparse.Find(id);
+            if (found != nullptr)
+                sum += *found;
+        }
+        DoNotOptimize(sum);
+    }, 5) / numLookups;
+    Report("find unordered_map", unorderedNs, unorderedNs);
+    Report("find FlatHashMap", flatNs, unorderedNs);
+    Report("find SparseSet", sparseNs, unorderedNs);
+
+    // A second set sharing half the ids.
+    FlatHashMap<uint32_t, float> otherFlat;
+    SparseSet<float> otherSparse;
+    for (uint32_t i = 0; i < numIds; ++i)
+    {
+        const uint32_t id = i % 2 == 0 ? ids[i] : random.Below(idRange);
+        otherFlat.Insert(id, 2.0f);
+        otherSparse.Insert(id, 2.0f);
+    }
+    double flatIntersectNs = MeasureNs([&]()
+    {
+        float sum = 0;
+        for (const FlatHashMapEntry<uint32_t, float>& entry : flat)
+        {
+            const float* found = otherFlat.Find(entry.m_Key);
+            if (found != nullptr)
+                sum += entry.m_Value * *found;
+        }
+        DoNotOptimize(sum);
+    }, 20) / numIds;
+    double sparseIntersectNs = MeasureNs([&]()
+    {
+        float sum = 0;
+        sparse.Intersect(otherSparse, [&](uint32_t, float& value, const float& otherValue) { sum += value * otherValue; });
+        DoNotOptimize(sum);
+    }, 20) / numIds;
+    Report("intersect FlatHashMap", flatIntersectNs, flatIntersectNs);
+    Report("intersect SparseSet", sparseIntersectNs, flatIntersectNs);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    for (const BenchmarkEntry& entry : Benchmarks())
+    {
+        if (filter != nullptr && strstr(entry.m_Name, filter) == nullptr)
+            continue;
+        printf("[%s]\n", entry.m_Name);
+        entry.m_Function();
+        printf("\n");
+    }
+    return 0;
+}
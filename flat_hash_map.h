@@ -0,0 +1,646 @@
+#pragma once
+#include "array.h"
+
+#include <functional>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Open-addressing hash tables. Every slot has a control byte, and the control bytes and
+// slots live in two flat arrays, so a lookup touches one 16 byte group of control bytes
+// and usually a single slot. The groups are compared 16 bytes at a time: a control byte
+// holds 7 bits of the hash of a full slot, so only slots whose bits match have their key
+// compared. Probing moves from group to group and stops at the first group with an empty
+// slot; tables are kept at most 7/8 full.
+//
+// The Allocator argument may be an allocator for any type; it is rebound for the control
+// bytes and the slots.
+
+// Bit masks over the 16 control bytes of a group, bit i standing for byte i.
+struct FlatHashGroup
+{
+    enum : uint32_t { SIZE = 16 };
+    enum : uint8_t
+    {
+        EMPTY = 0x00,
+        DELETED = 0x01,
+        FULL = 0x80,
+    };
+
+#if defined(__SSE2__)
+    static uint32_t Match(const uint8_t* control, uint8_t tag)
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(tag)))));
+    }
+
+    // Bytes that are not FULL, i.e. empty or deleted.
+    static uint32_t MatchAvailable(const uint8_t* control)
+    {
+        const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control));
+        return static_cast<uint32_t>(_mm_movemask_epi8(group)) ^ 0xFFFF;
+    }
+#else
+    static uint32_t Match(const uint8_t* control, uint8_t tag)
+    {
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < SIZE; ++i)
+            mask |= static_cast<uint32_t>(control[i] == tag) << i;
+        return mask;
+    }
+
+    static uint32_t MatchAvailable(const uint8_t* control)
+    {
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < SIZE; ++i)
+            mask |= static_cast<uint32_t>((control[i] & FULL) == 0) << i;
+        return mask;
+    }
+#endif
+
+    static uint32_t MatchEmpty(const uint8_t* control) { return Match(control, EMPTY); }
+};
+
+// Mixes a hash with a 64x64 -> 128 bit multiply, folding the high half into the low one, as
+// std::hash is the identity for integers. Compilers without a 128 bit integer type get
+// the same result from four 32 bit multiplies.
+struct FlatHashMix
+{
+    enum : uint64_t { MULTIPLIER = 0x9E3779B97F4A7C15ull };
+
+    static uint64_t Mix(uint64_t hash)
+    {
+#if defined(__SIZEOF_INT128__)
+        const __uint128_t product = static_cast<__uint128_t>(hash) * MULTIPLIER;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+#else
+        return MixPortable(hash);
+#endif
+    }
+
+    static uint64_t MixPortable(uint64_t hash)
+    {
+        const uint64_t aLow = hash & 0xFFFFFFFF;
+        const uint64_t aHigh = hash >> 32;
+        const uint64_t bLow = MULTIPLIER & 0xFFFFFFFF;
+        const uint64_t bHigh = MULTIPLIER >> 32;
+        const uint64_t lowLow = aLow * bLow;
+        const uint64_t lowHigh = aLow * bHigh;
+        const uint64_t highLow = aHigh * bLow;
+        const uint64_t highHigh = aHigh * bHigh;
+        const uint64_t middle = (lowLow >> 32) + (lowHigh & 0xFFFFFFFF) + (highLow & 0xFFFFFFFF);
+        const uint64_t low = (middle << 32) | (lowLow & 0xFFFFFFFF);
+        const uint64_t high = highHigh + (lowHigh >> 32) + (highLow >> 32) + (middle >> 32);
+        return low ^ high;
+    }
+};
+
+// The table shared by FlatHashMap and FlatHashSet. Policy provides the slot type and
+// static const Key& KeyOf(const Slot&).
+template<typename Key, typename Policy, typename Hash, typename Equal, typename Allocator>
+class FlatHashTable
+{
+public:
+    typedef typename Policy::Slot Slot;
+
+    template<typename SlotType>
+    class IteratorT
+    {
+    public:
+        IteratorT(const uint8_t* control, SlotType* slot, SlotType* end)
+            : m_Control(control)
+            , m_Slot(slot)
+            , m_End(end)
+        {
+            SkipAvailable();
+        }
+
+        SlotType& operator*() const { return *m_Slot; }
+        SlotType* operator->() const { return m_Slot; }
+        IteratorT& operator++()
+        {
+            ++m_Control;
+            ++m_Slot;
+            SkipAvailable();
+            return *this;
+        }
+        bool operator==(const IteratorT& other) const { return m_Slot == other.m_Slot; }
+        bool operator!=(const IteratorT& other) const { return m_Slot != other.m_Slot; }
+
+    private:
+        void SkipAvailable()
+        {
+            while (m_Slot != m_End && (*m_Control & FlatHashGroup::FULL) == 0)
+            {
+                ++m_Control;
+                ++m_Slot;
+            }
+        }
+
+        const uint8_t* m_Control;
+        SlotType* m_Slot;
+        SlotType* m_End;
+    };
+
+    typedef IteratorT<Slot> Iterator;
+    typedef IteratorT<const Slot> ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    explicit FlatHashTable(const Hash& hash = Hash(), const Equal& equal = Equal(), const Allocator& allocator = Allocator())
+        : m_Control(ControlRebind::Convert(allocator))
+        , m_Slots(SlotRebind::Convert(allocator))
+        , m_Size(0)
+        , m_GrowthLeft(0)
+        , m_Hash(hash)
+        , m_Equal(equal)
+    {
+    }
+
+    FlatHashTable(const FlatHashTable& other)
+        : m_Control(other.m_Control)
+        , m_Slots(other.m_Slots.GetAllocator())
+        , m_Size(other.m_Size)
+        , m_GrowthLeft(other.m_GrowthLeft)
+        , m_Hash(other.m_Hash)
+        , m_Equal(other.m_Equal)
+    {
+        m_Slots.Reserve(other.Capacity());
+        const Slot* source = other.m_Slots.GetBuffer();
+        for (uint32_t i = 0; i < Capacity(); ++i)
+        {
+            if (m_Control.Unchecked(i) & FlatHashGroup::FULL)
+                new (&m_Slots.GetBuffer()[i]) Slot(source[i]);
+        }
+    }
+
+    FlatHashTable(FlatHashTable&& other)
+        : m_Control(std::move(other.m_Control))
+        , m_Slots(std::move(other.m_Slots))
+        , m_Size(other.m_Size)
+        , m_GrowthLeft(other.m_GrowthLeft)
+        , m_Hash(other.m_Hash)
+        , m_Equal(other.m_Equal)
+    {
+        other.m_Size = 0;
+        other.m_GrowthLeft = 0;
+    }
+
+    ~FlatHashTable() { DestroySlots(); }
+
+    FlatHashTable& operator=(const FlatHashTable& other)
+    {
+        if (this != &other)
+        {
+            FlatHashTable copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    FlatHashTable& operator=(FlatHashTable&& other)
+    {
+        if (this != &other)
+        {
+            FlatHashTable moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(FlatHashTable& other)
+    {
+        m_Control.Swap(other.m_Control);
+        m_Slots.Swap(other.m_Slots);
+        std::swap(m_Size, other.m_Size);
+        std::swap(m_GrowthLeft, other.m_GrowthLeft);
+        std::swap(m_Hash, other.m_Hash);
+        std::swap(m_Equal, other.m_Equal);
+    }
+
+    Iterator begin() { return Iterator(m_Control.GetBuffer(), m_Slots.GetBuffer(), m_Slots.GetBuffer() + Capacity()); }
+    Iterator end() { return Iterator(nullptr, m_Slots.GetBuffer() + Capacity(), m_Slots.GetBuffer() + Capacity()); }
+    ConstIterator begin() const { return ConstIterator(m_Control.GetBuffer(), m_Slots.GetBuffer(), m_Slots.GetBuffer() + Capacity()); }
+    ConstIterator end() const { return ConstIterator(nullptr, m_Slots.GetBuffer() + Capacity(), m_Slots.GetBuffer() + Capacity()); }
+
+    uint32_t Size() const { return m_Size; }
+    bool Empty() const { return m_Size == 0; }
+    // Number of slots, a power of two. Up to 7/8 of them can be filled.
+    uint32_t Capacity() const { return m_Control.Size(); }
+
+    // Makes room for count elements in total, so that inserting them won't rehash.
+    void Reserve(uint32_t count)
+    {
+        const uint32_t capacity = CapacityFor(count);
+        if (capacity > Capacity())
+            Rehash(capacity);
+        else if (count > m_Size && count - m_Size > m_GrowthLeft)
+            Rehash(Capacity());
+    }
+
+    void Clear()
+    {
+        DestroySlots();
+        if (Capacity() > 0)
+            memset(m_Control.GetBuffer(), FlatHashGroup::EMPTY, Capacity());
+        m_Size = 0;
+        m_GrowthLeft = MaxLoad(Capacity());
+    }
+
+    Slot* Find(const Key& key)
+    {
+        const uint32_t index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &m_Slots.GetBuffer()[index];
+    }
+
+    const Slot* Find(const Key& key) const
+    {
+        const uint32_t index = FindIndex(key);
+        return index == NOT_FOUND ? nullptr : &m_Slots.GetBuffer()[index];
+    }
+
+    bool Contains(const Key& key) const { return FindIndex(key) != NOT_FOUND; }
+
+    // Returns the slot holding key, or, with inserted set, an uninitialized slot the caller
+    // must construct an element with that key in. key must not refer to an element of this
+    // table, since the table may grow.
+    Slot* FindOrPrepare(const Key& key, bool& inserted)
+    {
+        const uint64_t hash = HashOf(key);
+        if (m_Size > 0)
+        {
+            const uint32_t found = FindIndex(key, hash);
+            if (found != NOT_FOUND)
+            {
+                inserted = false;
+                return &m_Slots.GetBuffer()[found];
+            }
+        }
+        inserted = true;
+        uint32_t index = FindAvailable(hash);
+        if (m_GrowthLeft == 0 && m_Control.Unchecked(index) == FlatHashGroup::EMPTY)
+        {
+            Grow();
+            index = FindAvailable(hash);
+        }
+        Occupy(index, TagOf(hash));
+        return &m_Slots.GetBuffer()[index];
+    }
+
+    bool Remove(const Key& key)
+    {
+        const uint32_t index = FindIndex(key);
+        if (index == NOT_FOUND)
+            return false;
+        m_Slots.GetBuffer()[index].~Slot();
+        // Probes only continue past groups without an empty slot, so a slot in a group that
+        // has one can become empty again rather than a tombstone.
+        const uint32_t groupStart = index & ~(FlatHashGroup::SIZE - 1);
+        if (FlatHashGroup::MatchEmpty(&m_Control.GetBuffer()[groupStart]) != 0)
+        {
+            m_Control.Unchecked(index) = FlatHashGroup::EMPTY;
+            ++m_GrowthLeft;
+        }
+        else
+        {
+            m_Control.Unchecked(index) = FlatHashGroup::DELETED;
+        }
+        --m_Size;
+        return true;
+    }
+
+    // Prefetches the control group key hashes to, for bulk operations that know their
+    // keys ahead of time.
+    void Prefetch(const Key& key) const
+    {
+        if (Capacity() > 0)
+            __builtin_prefetch(&m_Control.GetBuffer()[GroupOf(HashOf(key), Capacity() / FlatHashGroup::SIZE - 1) * FlatHashGroup::SIZE]);
+    }
+
+private:
+    typedef AllocatorRebind<Allocator, uint8_t> ControlRebind;
+    typedef AllocatorRebind<Allocator, Slot> SlotRebind;
+    typedef BigArray<uint8_t, typename ControlRebind::Other, ExactGrowthPolicy> ControlArray;
+    // Only the buffer is used: elements are constructed in place and the array's size
+    // stays zero, so the table destroys them itself.
+    typedef BigArray<Slot, typename SlotRebind::Other, ExactGrowthPolicy> SlotArray;
+
+    // An empty table of capacity slots using other's allocators, hash and equality.
+    FlatHashTable(const FlatHashTable& other, uint32_t capacity)
+        : m_Control(other.m_Control.GetAllocator())
+        , m_Slots(other.m_Slots.GetAllocator())
+        , m_Size(0)
+        , m_GrowthLeft(MaxLoad(capacity))
+        , m_Hash(other.m_Hash)
+        , m_Equal(other.m_Equal)
+    {
+        m_Control.ResizeZeroed(capacity);
+        m_Slots.Reserve(capacity);
+    }
+
+
+    enum : uint32_t { NOT_FOUND = 0xFFFFFFFF };
+
+    static uint32_t MaxLoad(uint32_t capacity) { return capacity - capacity / 8; }
+
+    static uint32_t CapacityFor(uint32_t count)
+    {
+        uint32_t capacity = FlatHashGroup::SIZE;
+        while (MaxLoad(capacity) < count)
+            capacity *= 2;
+        return capacity;
+    }
+
+    // The low 7 bits of the mixed hash make the tag and the rest select the group.
+    uint64_t HashOf(const Key& key) const { return FlatHashMix::Mix(static_cast<uint64_t>(m_Hash(key))); }
+
+    static uint8_t TagOf(uint64_t hash) { return static_cast<uint8_t>(FlatHashGroup::FULL | (hash & 0x7F)); }
+    static uint32_t GroupOf(uint64_t hash, uint32_t groupMask) { return static_cast<uint32_t>(hash >> 7) & groupMask; }
+
+    uint32_t FindIndex(const Key& key) const
+    {
+        if (m_Size == 0)
+            return NOT_FOUND;
+        return FindIndex(key, HashOf(key));
+    }
+
+    uint32_t FindIndex(const Key& key, uint64_t hash) const
+    {
+        const uint8_t tag = TagOf(hash);
+        const uint32_t groupMask = Capacity() / FlatHashGroup::SIZE - 1;
+        uint32_t group = GroupOf(hash, groupMask);
+        // Moving by 1, 2, 3... groups visits every group, as the group count is a power of two.
+        for (uint32_t step = 1;; ++step)
+        {
+            const uint8_t* control = &m_Control.GetBuffer()[group * FlatHashGroup::SIZE];
+            for (uint32_t matches = FlatHashGroup::Match(control, tag); matches != 0; matches &= matches - 1)
+            {
+                const uint32_t index = group * FlatHashGroup::SIZE + __builtin_ctz(matches);
+                if (m_Equal(Policy::KeyOf(m_Slots.GetBuffer()[index]), key))
+                    return index;
+            }
+            if (FlatHashGroup::MatchEmpty(control) != 0)
+                return NOT_FOUND;
+            group = (group + step) & groupMask;
+        }
+    }
+
+    // First empty or deleted slot on the probe sequence of hash.
+    uint32_t FindAvailable(uint64_t hash)
+    {
+        if (Capacity() == 0)
+            Rehash(FlatHashGroup::SIZE);
+        const uint32_t groupMask = Capacity() / FlatHashGroup::SIZE - 1;
+        uint32_t group = GroupOf(hash, groupMask);
+        for (uint32_t step = 1;; ++step)
+        {
+            const uint32_t available = FlatHashGroup::MatchAvailable(&m_Control.GetBuffer()[group * FlatHashGroup::SIZE]);
+            if (available != 0)
+                return group * FlatHashGroup::SIZE + __builtin_ctz(available);
+            group = (group + step) & groupMask;
+        }
+    }
+
+    void Occupy(uint32_t index, uint8_t tag)
+    {
+        if (m_Control.Unchecked(index) == FlatHashGroup::EMPTY)
+            --m_GrowthLeft;
+        m_Control.Unchecked(index) = tag;
+        ++m_Size;
+    }
+
+    // Out of empty slots: doubles the capacity, or when tombstones rather than elements
+    // used them up, rehashes at the same capacity to clear them.
+    void Grow()
+    {
+        if (m_Size >= MaxLoad(Capacity()) / 2)
+            Rehash(Capacity() * 2);
+        else
+            Rehash(Capacity());
+    }
+
+    // Moves every element into fresh arrays of capacity slots.
+    void Rehash(uint32_t capacity)
+    {
+        ASSERT(capacity >= FlatHashGroup::SIZE && (capacity & (capacity - 1)) == 0 && MaxLoad(capacity) >= m_Size);
+        FlatHashTable table(*this, capacity);
+        Slot* slots = m_Slots.GetBuffer();
+        for (uint32_t i = 0; i < Capacity(); ++i)
+        {
+            if ((m_Control.Unchecked(i) & FlatHashGroup::FULL) == 0)
+                continue;
+            const uint64_t hash = HashOf(Policy::KeyOf(slots[i]));
+            const uint32_t index = table.FindAvailable(hash);
+            table.Occupy(index, TagOf(hash));
+            new (&table.m_Slots.GetBuffer()[index]) Slot(std::move(slots[i]));
+            slots[i].~Slot();
+            m_Control.Unchecked(i) = FlatHashGroup::EMPTY;
+        }
+        m_Size = 0;
+        Swap(table);
+    }
+
+    void DestroySlots()
+    {
+        if (std::is_trivially_destructible<Slot>::value || m_Size == 0)
+            return;
+        Slot* slots = m_Slots.GetBuffer();
+        for (uint32_t i = 0; i < Capacity(); ++i)
+        {
+            if (m_Control.Unchecked(i) & FlatHashGroup::FULL)
+                slots[i].~Slot();
+        }
+    }
+
+    ControlArray m_Control;
+    SlotArray m_Slots;
+    uint32_t m_Size;
+    // Empty slots that can still be filled before the table is over 7/8 full.
+    uint32_t m_GrowthLeft;
+    Hash m_Hash;
+    Equal m_Equal;
+};
+
+template<typename Key, typename Value>
+struct FlatHashMapEntry
+{
+    template<typename... Args>
+    explicit FlatHashMapEntry(const Key& key, Args&&... args)
+        : m_Key(key)
+        , m_Value(std::forward<Args>(args)...)
+    {
+    }
+
+    Key m_Key;
+    Value m_Value;
+};
+
+// Maps keys to values. Iteration visits FlatHashMapEntry objects in no particular order;
+// their keys must not be modified.
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>, typename Allocator = DefaultAllocatorT<Key>>
+class FlatHashMap
+{
+    struct Policy
+    {
+        typedef FlatHashMapEntry<Key, Value> Slot;
+        static const Key& KeyOf(const Slot& slot) { return slot.m_Key; }
+    };
+    typedef FlatHashTable<Key, Policy, Hash, Equal, Allocator> Table;
+public:
+    typedef FlatHashMapEntry<Key, Value> Entry;
+    typedef typename Table::Iterator Iterator;
+    typedef typename Table::ConstIterator ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    FlatHashMap() {}
+    explicit FlatHashMap(const Allocator& allocator, const Hash& hash = Hash(), const Equal& equal = Equal())
+        : m_Table(hash, equal, allocator)
+    {
+    }
+
+    Iterator begin() { return m_Table.begin(); }
+    Iterator end() { return m_Table.end(); }
+    ConstIterator begin() const { return m_Table.begin(); }
+    ConstIterator end() const { return m_Table.end(); }
+
+    uint32_t Size() const { return m_Table.Size(); }
+    bool Empty() const { return m_Table.Empty(); }
+    uint32_t Capacity() const { return m_Table.Capacity(); }
+    void Reserve(uint32_t count) { m_Table.Reserve(count); }
+    void Clear() { m_Table.Clear(); }
+    void Swap(FlatHashMap& other) { m_Table.Swap(other.m_Table); }
+
+    Value* Find(const Key& key)
+    {
+        Entry* entry = m_Table.Find(key);
+        return entry == nullptr ? nullptr : &entry->m_Value;
+    }
+
+    const Value* Find(const Key& key) const
+    {
+        const Entry* entry = m_Table.Find(key);
+        return entry == nullptr ? nullptr : &entry->m_Value;
+    }
+
+    bool Contains(const Key& key) const { return m_Table.Contains(key); }
+
+    // Adds key with a value constructed from args unless key is already present. Returns
+    // whether it was added.
+    template<typename... Args>
+    bool Emplace(const Key& key, Args&&... args)
+    {
+        bool inserted;
+        Entry* entry = m_Table.FindOrPrepare(key, inserted);
+        if (inserted)
+            new (entry) Entry(key, std::forward<Args>(args)...);
+        return inserted;
+    }
+
+    bool Insert(const Key& key, const Value& value) { return Emplace(key, value); }
+    bool Insert(const Key& key, Value&& value) { return Emplace(key, std::move(value)); }
+
+    // The value for key, default constructed first if key is not present.
+    Value& operator[](const Key& key)
+    {
+        bool inserted;
+        Entry* entry = m_Table.FindOrPrepare(key, inserted);
+        if (inserted)
+            new (entry) Entry(key);
+        return entry->m_Value;
+    }
+
+    bool Remove(const Key& key) { return m_Table.Remove(key); }
+
+    // Adds keys[i] -> values[i] for each i below count, reserving once. Keys that are
+    // already present, or repeat within keys, keep their first value.
+    void InsertRange(const Key* keys, const Value* values, uint32_t count)
+    {
+        m_Table.Reserve(m_Table.Size() + count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i + PREFETCH_DISTANCE < count)
+                m_Table.Prefetch(keys[i + PREFETCH_DISTANCE]);
+            Emplace(keys[i], values[i]);
+        }
+    }
+
+    template<typename CountType1, typename CountType2, typename Allocator1, typename Allocator2, typename Growth1, typename Growth2, typename Check1, typename Check2, bool Copyable1, bool Copyable2>
+    void InsertRange(const BaseArray<CountType1, Key, Allocator1, Growth1, Check1, Copyable1>& keys, const BaseArray<CountType2, Value, Allocator2, Growth2, Check2, Copyable2>& values)
+    {
+        ASSERT(static_cast<size_t>(keys.Size()) == static_cast<size_t>(values.Size()));
+        InsertRange(keys.GetBuffer(), values.GetBuffer(), static_cast<uint32_t>(keys.Size()));
+    }
+
+private:
+    enum : uint32_t { PREFETCH_DISTANCE = 8 };
+
+    Table m_Table;
+};
+
+template<typename Key, typename Hash = std::hash<Key>, typename Equal = std::equal_to<Key>, typename Allocator = DefaultAllocatorT<Key>>
+class FlatHashSet
+{
+    struct Policy
+    {
+        typedef Key Slot;
+        static const Key& KeyOf(const Slot& slot) { return slot; }
+    };
+    typedef FlatHashTable<Key, Policy, Hash, Equal, Allocator> Table;
+public:
+    typedef typename Table::ConstIterator Iterator;
+    typedef typename Table::ConstIterator ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    FlatHashSet() {}
+    explicit FlatHashSet(const Allocator& allocator, const Hash& hash = Hash(), const Equal& equal = Equal())
+        : m_Table(hash, equal, allocator)
+    {
+    }
+
+    ConstIterator begin() const { return m_Table.begin(); }
+    ConstIterator end() const { return m_Table.end(); }
+
+    uint32_t Size() const { return m_Table.Size(); }
+    bool Empty() const { return m_Table.Empty(); }
+    uint32_t Capacity() const { return m_Table.Capacity(); }
+    void Reserve(uint32_t count) { m_Table.Reserve(count); }
+    void Clear() { m_Table.Clear(); }
+    void Swap(FlatHashSet& other) { m_Table.Swap(other.m_Table); }
+
+    bool Contains(const Key& key) const { return m_Table.Contains(key); }
+
+    bool Insert(const Key& key)
+    {
+        bool inserted;
+        Key* slot = m_Table.FindOrPrepare(key, inserted);
+        if (inserted)
+            new (slot) Key(key);
+        return inserted;
+    }
+
+    bool Remove(const Key& key) { return m_Table.Remove(key); }
+
+    void InsertRange(const Key* keys, uint32_t count)
+    {
+        m_Table.Reserve(m_Table.Size() + count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (i + PREFETCH_DISTANCE < count)
+                m_Table.Prefetch(keys[i + PREFETCH_DISTANCE]);
+            Insert(keys[i]);
+        }
+    }
+
+    template<typename CountType, typename KeyAllocator, typename GrowthPolicy, typename CheckPolicy, bool IsCopyable>
+    void InsertRange(const BaseArray<CountType, Key, KeyAllocator, GrowthPolicy, CheckPolicy, IsCopyable>& keys)
+    {
+        InsertRange(keys.GetBuffer(), static_cast<uint32_t>(keys.Size()));
+    }
+
+private:
+    enum : uint32_t { PREFETCH_DISTANCE = 8 };
+
+    Table m_Table;
+};
@@ -0,0 +1,227 @@
+#pragma once
+#include "array.h"
+
+#include <stddef.h>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Backs large buffers with transparent huge pages to cut TLB misses in random-access scans.
+// Blocks of at least THRESHOLD_BYTES are mmapped on a 2 MiB boundary and advised with
+// MADV_HUGEPAGE; if the kernel declines, they simply stay ordinary pages. Smaller blocks
+// come from malloc. Every block carries a header in front of the data recording how it
+// was obtained. Failures return nullptr, leaving any existing block untouched, so
+// BaseArray's Try functions can report them.
+class HugePageHeap
+{
+public:
+    enum : size_t
+    {
+        HUGE_PAGE_SIZE = 2 * 1024 * 1024,
+        HEADER_PAGE_SIZE = 4096,
+    };
+
+    static void* Allocate(size_t bytes, size_t thresholdBytes)
+    {
+#if defined(__linux__)
+        if (bytes >= thresholdBytes)
+            return MapHuge(bytes);
+#endif
+        return InitMalloced(static_cast<Header*>(malloc(sizeof(Header) + bytes)), bytes);
+    }
+
+    // Fresh mappings are zero-filled by the kernel, so only malloc'd blocks need clearing.
+    static void* AllocateZeroed(size_t bytes, size_t thresholdBytes)
+    {
+#if defined(__linux__)
+        if (bytes >= thresholdBytes)
+            return MapHuge(bytes);
+#endif
+        return InitMalloced(static_cast<Header*>(calloc(1, sizeof(Header) + bytes)), bytes);
+    }
+
+    static void Free(void* data)
+    {
+        if (data == nullptr)
+            return;
+        Header* header = GetHeader(data);
+#if defined(__linux__)
+        if (header->m_Length != 0)
+        {
+            munmap(header->m_Base, header->m_Length);
+            return;
+        }
+#endif
+        free(header->m_Base);
+    }
+
+    // Mapped blocks are rounded up to whole huge pages, so they can grow into the slack.
+    static bool TryExpand(void* data, size_t bytes)
+    {
+        if (data == nullptr)
+            return false;
+        return bytes <= Capacity(data);
+    }
+
+    static void* Reallocate(void* data, size_t bytes, size_t thresholdBytes)
+    {
+        if (data == nullptr)
+            return Allocate(bytes, thresholdBytes);
+        Header* header = GetHeader(data);
+#if defined(__linux__)
+        if (header->m_Length != 0 && bytes >= thresholdBytes)
+            return RemapHuge(data, bytes);
+#endif
+        if (header->m_Length == 0 && bytes < thresholdBytes)
+        {
+            Header* newHeader = static_cast<Header*>(realloc(header, sizeof(Header) + bytes));
+            if (newHeader == nullptr)
+                return nullptr;
+            newHeader->m_Base = newHeader;
+            newHeader->m_Bytes = bytes;
+            return newHeader + 1;
+        }
+        const size_t usedBytes = Capacity(data);
+        void* newData = Allocate(bytes, thresholdBytes);
+        if (newData == nullptr)
+            return nullptr;
+        memcpy(newData, data, usedBytes < bytes ? usedBytes : bytes);
+        Free(data);
+        return newData;
+    }
+
+    // Bytes usable at data without reallocating.
+    static size_t Capacity(void* data)
+    {
+        Header* header = GetHeader(data);
+        if (header->m_Length == 0)
+            return header->m_Bytes;
+        return header->m_Length - HEADER_PAGE_SIZE;
+    }
+
+    static bool IsHugeMapped(void* data) { return data != nullptr && GetHeader(data)->m_Length != 0; }
+
+private:
+    // m_Length is the length of the mapping, or 0 for malloc'd blocks of m_Bytes.
+    struct Header
+    {
+        void* m_Base;
+        size_t m_Length;
+        size_t m_Bytes;
+        size_t m_Padding;
+    };
+
+    static Header* GetHeader(void* data) { return static_cast<Header*>(data) - 1; }
+
+    static void* InitMalloced(Header* header, size_t bytes)
+    {
+        if (header == nullptr)
+            return nullptr;
+        header->m_Base = header;
+        header->m_Length = 0;
+        header->m_Bytes = bytes;
+        return header + 1;
+    }
+
+    static size_t RoundUp(size_t value, size_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+#if defined(__linux__)
+    // Reserves address space for a mapping of length bytes whose data starts on a huge page
+    // boundary, with one small page in front for the header. Returns the mapping start, or
+    // nullptr if the address space is exhausted.
+    static char* ReserveAligned(size_t length)
+    {
+        const size_t reserved = length + HUGE_PAGE_SIZE;
+        void* region = mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (region == MAP_FAILED)
+            return nullptr;
+        char* start = static_cast<char*>(region);
+        char* data = reinterpret_cast<char*>(RoundUp(reinterpret_cast<uintptr_t>(start) + HEADER_PAGE_SIZE, HUGE_PAGE_SIZE));
+        char* mapStart = data - HEADER_PAGE_SIZE;
+        if (mapStart > start)
+            munmap(start, mapStart - start);
+        char* mapEnd = mapStart + length;
+        if (start + reserved > mapEnd)
+            munmap(mapEnd, start + reserved - mapEnd);
+        return mapStart;
+    }
+
+    static void* Finish(char* mapStart, size_t length)
+    {
+        char* data = mapStart + HEADER_PAGE_SIZE;
+#if defined(MADV_HUGEPAGE)
+        // Advise the header page too, so the mapping stays a single VMA that mremap can move.
+        madvise(mapStart, length, MADV_HUGEPAGE);
+#endif
+        Header* header = GetHeader(data);
+        header->m_Base = mapStart;
+        header->m_Length = length;
+        header->m_Bytes = length - HEADER_PAGE_SIZE;
+        return data;
+    }
+
+    static void* MapHuge(size_t bytes)
+    {
+        const size_t length = HEADER_PAGE_SIZE + RoundUp(bytes, HUGE_PAGE_SIZE);
+        char* mapStart = ReserveAligned(length);
+        if (mapStart == nullptr)
+            return nullptr;
+        void* mapped = mmap(mapStart, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if (mapped != mapStart)
+        {
+            munmap(mapStart, length);
+            return nullptr;
+        }
+        return Finish(mapStart, length);
+    }
+
+    // Moves the page tables of an existing mapping to a new aligned range instead of
+    // copying the data.
+    static void* RemapHuge(void* data, size_t bytes)
+    {
+        Header* header = GetHeader(data);
+        const size_t length = HEADER_PAGE_SIZE + RoundUp(bytes, HUGE_PAGE_SIZE);
+        if (length == header->m_Length)
+            return data;
+        if (length < header->m_Length)
+        {
+            char* mapStart = static_cast<char*>(header->m_Base);
+            munmap(mapStart + length, header->m_Length - length);
+            header->m_Length = length;
+            header->m_Bytes = length - HEADER_PAGE_SIZE;
+            return data;
+        }
+        char* mapStart = ReserveAligned(length);
+        if (mapStart == nullptr)
+            return nullptr;
+        void* moved = mremap(header->m_Base, header->m_Length, length, MREMAP_MAYMOVE | MREMAP_FIXED, mapStart);
+        if (moved != mapStart)
+        {
+            munmap(mapStart, length);
+            return nullptr;
+        }
+        return Finish(mapStart, length);
+    }
+#endif
+};
+
+// Allocator for large BigArray buffers. Buffers of at least THRESHOLD_BYTES use huge
+// pages; growth of a huge buffer remaps its pages rather than copying them.
+template<typename T, size_t THRESHOLD_BYTES = HugePageHeap::HUGE_PAGE_SIZE>
+struct HugePageAllocatorT
+{
+    static_assert(alignof(T) <= 16, "HugePageAllocatorT only supports alignments up to 16 bytes");
+
+    template<typename U>
+    struct Rebind
+    {
+        typedef HugePageAllocatorT<U, THRESHOLD_BYTES> Other;
+    };
+
+    static T* Allocate(uint32_t numItems) { return static_cast<T*>(HugePageHeap::Allocate(sizeof(T) * numItems, THRESHOLD_BYTES)); }
+    static void Free(T* data) { HugePageHeap::Free(data); }
+    static bool TryExpand(T* data, uint32_t numItems) { return HugePageHeap::TryExpand(data, sizeof(T) * numItems); }
+    static T* Reallocate(T* data, uint32_t numItems) { return static_cast<T*>(HugePageHeap::Reallocate(data, sizeof(T) * numItems, THRESHOLD_BYTES)); }
+    static T* AllocateZeroed(uint32_t numItems) { return static_cast<T*>(HugePageHeap::AllocateZeroed(sizeof(T) * numItems, THRESHOLD_BYTES)); }
+};
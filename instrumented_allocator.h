@@ -0,0 +1,312 @@
+#pragma once
+#include "array.h"
+
+#include <stdio.h>
+
+// Allocation telemetry for arrays. Wrap an allocator in InstrumentedAllocatorT to count,
+// per element type and optional callsite tag, the allocations, frees, bytes, peak live
+// bytes and the elements BaseArray had to move when reallocating. Call
+// AllocationTelemetry::Report to print the numbers, or ReportAtExit to have them printed
+// at shutdown.
+//
+// Building with ARRAY_ALLOCATION_TELEMETRY=0 turns InstrumentedAllocatorT into an alias
+// of the wrapped allocator and the reports into no-ops, so instrumented code costs nothing.
+#ifndef ARRAY_ALLOCATION_TELEMETRY
+#define ARRAY_ALLOCATION_TELEMETRY 1
+#endif
+
+// Default callsite tag. Declare further tags with DECLARE_ALLOCATION_TAG(Name) and pass
+// them as the Tag argument to split the numbers for one element type by callsite.
+struct UntaggedAllocation
+{
+    static const char* Name() { return "-"; }
+};
+
+#define DECLARE_ALLOCATION_TAG(name) \
+    struct name \
+    { \
+        static const char* Name() { return #name; } \
+    }
+
+#if ARRAY_ALLOCATION_TELEMETRY
+
+#include <atomic>
+#include <mutex>
+#include <stdlib.h>
+#include <typeinfo>
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#endif
+
+struct AllocationStats
+{
+    std::atomic<uint64_t> m_Allocations;
+    std::atomic<uint64_t> m_Frees;
+    std::atomic<uint64_t> m_Reallocations;
+    std::atomic<uint64_t> m_BytesAllocated;
+    std::atomic<uint64_t> m_LiveBytes;
+    std::atomic<uint64_t> m_PeakBytes;
+    std::atomic<uint64_t> m_RelocatedElements;
+    std::atomic<uint64_t> m_RelocatedBytes;
+
+    AllocationStats()
+        : m_Allocations(0)
+        , m_Frees(0)
+        , m_Reallocations(0)
+        , m_BytesAllocated(0)
+        , m_LiveBytes(0)
+        , m_PeakBytes(0)
+        , m_RelocatedElements(0)
+        , m_RelocatedBytes(0)
+    {
+    }
+
+    void OnAllocate(uint64_t bytes)
+    {
+        ++m_Allocations;
+        m_BytesAllocated += bytes;
+        AddLive(bytes);
+    }
+
+    void OnFree(uint64_t bytes)
+    {
+        ++m_Frees;
+        m_LiveBytes -= bytes;
+    }
+
+    // A block was resized, in place or not, from oldBytes to newBytes.
+    void OnResize(uint64_t oldBytes, uint64_t newBytes)
+    {
+        ++m_Reallocations;
+        if (newBytes > oldBytes)
+        {
+            m_BytesAllocated += newBytes - oldBytes;
+            AddLive(newBytes - oldBytes);
+        }
+        else
+        {
+            m_LiveBytes -= oldBytes - newBytes;
+        }
+    }
+
+    void OnRelocate(uint64_t numElements, uint64_t bytes)
+    {
+        m_RelocatedElements += numElements;
+        m_RelocatedBytes += bytes;
+    }
+
+private:
+    void AddLive(uint64_t bytes)
+    {
+        uint64_t live = m_LiveBytes += bytes;
+        uint64_t peak = m_PeakBytes.load();
+        while (live > peak && !m_PeakBytes.compare_exchange_weak(peak, live))
+        {
+        }
+    }
+};
+
+class AllocationTelemetry
+{
+public:
+    // Returns the stats for one element type and tag. The result lives until exit.
+    static AllocationStats& GetStats(const char* typeName, const char* tag)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        for (Entry* entry = registry.m_Entries; entry != nullptr; entry = entry->m_Next)
+        {
+            if (strcmp(entry->m_TypeName, typeName) == 0 && strcmp(entry->m_Tag, tag) == 0)
+                return entry->m_Stats;
+        }
+        Entry* entry = new Entry(typeName, tag);
+        entry->m_Next = registry.m_Entries;
+        registry.m_Entries = entry;
+        return entry->m_Stats;
+    }
+
+    template<typename T>
+    static const char* TypeName()
+    {
+        const char* name = typeid(T).name();
+#if defined(__GNUG__)
+        int status = 0;
+        // Leaked on purpose: names are cached for the lifetime of the process.
+        char* demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+        if (status == 0 && demangled != nullptr)
+            return demangled;
+#endif
+        return name;
+    }
+
+    static void Report(FILE* file = stderr)
+    {
+        Registry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.m_Mutex);
+        fprintf(file, "%-32s %-16s %10s %10s %10s %14s %14s %12s %14s\n", "type", "tag", "allocs", "frees",
+            "reallocs", "bytes", "peak bytes", "moved elems", "moved bytes");
+        for (Entry* entry = registry.m_Entries; entry != nullptr; entry = entry->m_Next)
+        {
+            const AllocationStats& stats = entry->m_Stats;
+            fprintf(file, "%-32s %-16s %10llu %10llu %10llu %14llu %14llu %12llu %14llu\n", entry->m_TypeName, entry->m_Tag,
+                static_cast<unsigned long long>(stats.m_Allocations.load()),
+                static_cast<unsigned long long>(stats.m_Frees.load()),
+                static_cast<unsigned long long>(stats.m_Reallocations.load()),
+                static_cast<unsigned long long>(stats.m_BytesAllocated.load()),
+                static_cast<unsigned long long>(stats.m_PeakBytes.load()),
+                static_cast<unsigned long long>(stats.m_RelocatedElements.load()),
+                static_cast<unsigned long long>(stats.m_RelocatedBytes.load()));
+        }
+    }
+
+    static void ReportAtExit()
+    {
+        static bool registered = false;
+        if (!registered)
+        {
+            registered = true;
+            atexit([]() { Report(stderr); });
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Entry(const char* typeName, const char* tag) : m_TypeName(typeName), m_Tag(tag), m_Next(nullptr) {}
+        const char* m_TypeName;
+        const char* m_Tag;
+        AllocationStats m_Stats;
+        Entry* m_Next;
+    };
+
+    struct Registry
+    {
+        Registry() : m_Entries(nullptr) {}
+        std::mutex m_Mutex;
+        Entry* m_Entries;
+    };
+
+    // Never destroyed, so arrays freed during static destruction can still report.
+    static Registry& GetRegistry()
+    {
+        static Registry* registry = new Registry();
+        return *registry;
+    }
+};
+
+// Forwards to Inner and records what happens. Each block carries its size in a small
+// header in front of the data so frees can be attributed without a lookup. Reallocate,
+// TryExpand and AllocateZeroed are only offered when Inner offers them.
+template<typename T, typename Inner = DefaultAllocatorT<T>, typename Tag = UntaggedAllocation>
+class InstrumentedAllocatorT : private AllocatorStorage<Inner>
+{
+    typedef AllocatorStorage<Inner> InnerStorage;
+public:
+    template<typename U>
+    struct Rebind
+    {
+        typedef InstrumentedAllocatorT<U, typename AllocatorRebind<Inner, U>::Other, Tag> Other;
+    };
+
+    InstrumentedAllocatorT() {}
+    explicit InstrumentedAllocatorT(const Inner& inner) : InnerStorage(inner) {}
+    template<typename U, typename OtherInner>
+    InstrumentedAllocatorT(const InstrumentedAllocatorT<U, OtherInner, Tag>& other)
+        : InnerStorage(AllocatorRebind<OtherInner, T>::Convert(other.GetInner()))
+    {
+    }
+
+    T* Allocate(uint32_t numItems)
+    {
+        T* block = GetInner().Allocate(numItems + HEADER_ITEMS);
+        if (block == nullptr)
+            return nullptr;
+        const uint64_t bytes = static_cast<uint64_t>(numItems) * sizeof(T);
+        WriteSize(block, bytes);
+        GetStats().OnAllocate(bytes);
+        return block + HEADER_ITEMS;
+    }
+
+    template<typename I = Inner>
+    auto AllocateZeroed(uint32_t numItems) -> decltype(std::declval<I&>().AllocateZeroed(numItems))
+    {
+        T* block = GetInner().AllocateZeroed(numItems + HEADER_ITEMS);
+        if (block == nullptr)
+            return nullptr;
+        const uint64_t bytes = static_cast<uint64_t>(numItems) * sizeof(T);
+        WriteSize(block, bytes);
+        GetStats().OnAllocate(bytes);
+        return block + HEADER_ITEMS;
+    }
+
+    void Free(T* data)
+    {
+        if (data == nullptr)
+            return;
+        T* block = data - HEADER_ITEMS;
+        GetStats().OnFree(ReadSize(block));
+        GetInner().Free(block);
+    }
+
+    template<typename I = Inner>
+    auto TryExpand(T* data, uint32_t numItems) -> decltype(std::declval<I&>().TryExpand(data, numItems))
+    {
+        T* block = data - HEADER_ITEMS;
+        if (!GetInner().TryExpand(block, numItems + HEADER_ITEMS))
+            return false;
+        const uint64_t bytes = static_cast<uint64_t>(numItems) * sizeof(T);
+        GetStats().OnResize(ReadSize(block), bytes);
+        WriteSize(block, bytes);
+        return true;
+    }
+
+    template<typename I = Inner>
+    auto Reallocate(T* data, uint32_t numItems) -> decltype(std::declval<I&>().Reallocate(data, numItems))
+    {
+        T* block = data - HEADER_ITEMS;
+        const uint64_t oldBytes = ReadSize(block);
+        block = GetInner().Reallocate(block, numItems + HEADER_ITEMS);
+        if (block == nullptr)
+            return nullptr;
+        const uint64_t bytes = static_cast<uint64_t>(numItems) * sizeof(T);
+        GetStats().OnResize(oldBytes, bytes);
+        WriteSize(block, bytes);
+        return block + HEADER_ITEMS;
+    }
+
+    void OnRelocate(uint32_t numItems) { GetStats().OnRelocate(numItems, static_cast<uint64_t>(numItems) * sizeof(T)); }
+
+    static AllocationStats& GetStats()
+    {
+        static AllocationStats& stats = AllocationTelemetry::GetStats(AllocationTelemetry::TypeName<T>(), Tag::Name());
+        return stats;
+    }
+
+    Inner& GetInner() { return InnerStorage::GetAllocator(); }
+    const Inner& GetInner() const { return InnerStorage::GetAllocator(); }
+
+private:
+    enum : uint32_t { HEADER_ITEMS = (sizeof(uint64_t) + sizeof(T) - 1) / sizeof(T) };
+
+    static void WriteSize(T* block, uint64_t bytes) { memcpy(static_cast<void*>(block), &bytes, sizeof(bytes)); }
+    static uint64_t ReadSize(const T* block)
+    {
+        uint64_t bytes;
+        memcpy(&bytes, static_cast<const void*>(block), sizeof(bytes));
+        return bytes;
+    }
+};
+
+#else
+
+template<typename T, typename Inner = DefaultAllocatorT<T>, typename Tag = UntaggedAllocation>
+using InstrumentedAllocatorT = Inner;
+
+class AllocationTelemetry
+{
+public:
+    static void Report(FILE* = stderr) {}
+    static void ReportAtExit() {}
+};
+
+#endif
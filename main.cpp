@@ -1,4 +1,25 @@
 #include "array.h"
+#include "arena_allocator.h"
+#include "pool_allocator.h"
+#include "huge_page_allocator.h"
+#include "instrumented_allocator.h"
+#include "sorted_array.h"
+#include "flat_hash_map.h"
+#include "soa_array.h"
+#include "segmented_array.h"
+#include "ring_array.h"
+#include "slot_map.h"
+#include "sparse_set.h"
+
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "catch.h"
 
@@ -262,3 +283,2157 @@ TEST_CASE("Grow")
     REQUIRE(array.Last() == 12);
 }
 
+
+TEST_CASE("Growth policy")
+{
+    SECTION("Default growth is geometric")
+    {
+        BigArray<int> array;
+        int reallocations = 0;
+        for (int i = 0; i < 10000; ++i)
+        {
+            auto capacity = array.Capacity();
+            array.Push(i);
+            if (array.Capacity() != capacity)
+                ++reallocations;
+        }
+        REQUIRE(array.Size() == 10000);
+        REQUIRE(reallocations < 32);
+        for (int i = 0; i < 10000; ++i)
+            REQUIRE(array[i] == i);
+    }
+    SECTION("Exact growth")
+    {
+        Array<NonPODObject, DefaultAllocatorT<NonPODObject>, ExactGrowthPolicy> array;
+        array.Push(1);
+        array.Push(2);
+        array.Grow() = 3;
+        REQUIRE(array.Capacity() == 3);
+        REQUIRE(array[2] == 3);
+    }
+    SECTION("Doubling growth")
+    {
+        Array<int, DefaultAllocatorT<int>, DoublingGrowthPolicy> array;
+        array.Push(1);
+        REQUIRE(array.Capacity() == 4);
+        array.Push({2, 3, 4, 5});
+        REQUIRE(array.Capacity() == 8);
+        array.Insert(0, 0);
+        REQUIRE(array.Capacity() == 8);
+        REQUIRE(array[0] == 0);
+        REQUIRE(array[5] == 5);
+    }
+    SECTION("Page rounded growth")
+    {
+        BigArray<uint64_t, DefaultAllocatorT<uint64_t>, PageRoundedGrowthPolicy<>> array;
+        array.Push(1);
+        REQUIRE(array.Capacity() == 4096 / sizeof(uint64_t));
+    }
+    SECTION("Growth is clamped to the count type")
+    {
+        Array<uint8_t> array;
+        array.Resize(60000);
+        array.Resize(65534);
+        REQUIRE(array.Size() == 65534);
+        REQUIRE(array.Capacity() == 65534);
+    }
+}
+
+// Hands out fixed 256 element blocks so TryExpand can succeed without moving anything.
+template<typename T>
+struct ExpandableAllocatorT
+{
+    static T* Allocate(uint32_t numItems) { ++s_Allocations; return static_cast<T*>(malloc(sizeof(T) * (numItems > 256 ? numItems : 256))); }
+    static void Free(T* data) { free(data); }
+    static bool TryExpand(T*, uint32_t numItems) { ++s_Expansions; return numItems <= 256; }
+    static int s_Allocations;
+    static int s_Expansions;
+};
+template<typename T> int ExpandableAllocatorT<T>::s_Allocations = 0;
+template<typename T> int ExpandableAllocatorT<T>::s_Expansions = 0;
+
+template<typename T>
+struct ReallocatingAllocatorT : DefaultAllocatorT<T>
+{
+    static T* Reallocate(T* data, uint32_t numItems) { ++s_Reallocations; return DefaultAllocatorT<T>::Reallocate(data, numItems); }
+    static int s_Reallocations;
+};
+template<typename T> int ReallocatingAllocatorT<T>::s_Reallocations = 0;
+
+TEST_CASE("Allocator expansion hooks")
+{
+    REQUIRE(AllocatorTraits<DefaultAllocatorT<int>, int>::HasReallocate::value);
+    REQUIRE(!AllocatorTraits<DefaultAllocatorT<int>, int>::HasTryExpand::value);
+    REQUIRE(AllocatorTraits<ExpandableAllocatorT<int>, int>::HasTryExpand::value);
+    SECTION("Reallocate is used for trivially movable types")
+    {
+        ReallocatingAllocatorT<uint64_t>::s_Reallocations = 0;
+        BigArray<uint64_t, ReallocatingAllocatorT<uint64_t>> array;
+        for (uint64_t i = 0; i < 1000; ++i)
+            array.Push(i);
+        REQUIRE(ReallocatingAllocatorT<uint64_t>::s_Reallocations > 0);
+        for (uint32_t i = 0; i < 1000; ++i)
+            REQUIRE(array[i] == i);
+    }
+    SECTION("TryExpand grows non-trivial types in place")
+    {
+        ExpandableAllocatorT<NonPODObject>::s_Allocations = 0;
+        Array<NonPODObject, ExpandableAllocatorT<NonPODObject>> array;
+        for (int i = 0; i < 200; ++i)
+            array.Push(i);
+        REQUIRE(ExpandableAllocatorT<NonPODObject>::s_Allocations == 1);
+        REQUIRE(ExpandableAllocatorT<NonPODObject>::s_Expansions > 0);
+        for (int i = 200; i < 300; ++i)
+            array.Push(i);
+        REQUIRE(ExpandableAllocatorT<NonPODObject>::s_Allocations == 2);
+        for (int i = 0; i < 300; ++i)
+            REQUIRE(array[i] == i);
+    }
+    SECTION("Borrowed buffers are never handed to the allocator")
+    {
+        ReallocatingAllocatorT<int>::s_Reallocations = 0;
+        InplaceArray<int, 2, ReallocatingAllocatorT<int>> array;
+        array.Push({1, 2, 3});
+        REQUIRE(ReallocatingAllocatorT<int>::s_Reallocations == 0);
+        REQUIRE(array.Size() == 3);
+        REQUIRE(array[2] == 3);
+    }
+}
+
+// Owns a heap value and counts live instances and move constructions.
+struct OwningObject
+{
+    OwningObject() : m_Value(new int(0)) { ++s_Live; }
+    OwningObject(int x) : m_Value(new int(x)) { ++s_Live; }
+    OwningObject(const OwningObject& other) : m_Value(new int(*other.m_Value)) { ++s_Live; }
+    OwningObject(OwningObject&& other) : m_Value(other.m_Value) { other.m_Value = nullptr; ++s_Live; ++s_Moves; }
+    OwningObject& operator=(const OwningObject& other) { *m_Value = *other.m_Value; return *this; }
+    OwningObject& operator=(OwningObject&& other) { std::swap(m_Value, other.m_Value); return *this; }
+    ~OwningObject() { delete m_Value; --s_Live; }
+    operator int() const { return *m_Value; }
+    int* m_Value;
+    static int s_Live;
+    static int s_Moves;
+};
+int OwningObject::s_Live = 0;
+int OwningObject::s_Moves = 0;
+
+struct RelocatableObject : OwningObject
+{
+    RelocatableObject(int x = 0) : OwningObject(x) {}
+};
+
+template<>
+struct IsTriviallyRelocatable<RelocatableObject> : std::true_type {};
+
+template<typename T>
+void CheckRelocation()
+{
+    OwningObject::s_Live = 0;
+    OwningObject::s_Moves = 0;
+    {
+        Array<T> array;
+        for (int i = 0; i < 100; ++i)
+            array.Push(T(i));
+        array.Insert(0, T(-1));
+        array.Insert(50, T(-2));
+        REQUIRE(array[0] == -1);
+        REQUIRE(array[50] == -2);
+        REQUIRE(array[51] == 49);
+        array.SetPreserveOrder(true);
+        array.RemoveAt(50);
+        array.RemoveAt(0);
+        for (int i = 0; i < 100; ++i)
+            REQUIRE(array[i] == i);
+        array.SetPreserveOrder(false);
+        array.RemoveAt(0);
+        REQUIRE(array.Size() == 99);
+        REQUIRE(array[0] == 99);
+        REQUIRE(OwningObject::s_Live == 99);
+
+        InplaceArray<T, 4> inplace;
+        inplace.Push({1, 2, 3});
+        Array<T> moved(std::move(inplace));
+        REQUIRE(moved.Size() == 3);
+        REQUIRE(inplace.Size() == 0);
+        REQUIRE(moved[2] == 3);
+    }
+    REQUIRE(OwningObject::s_Live == 0);
+}
+
+TEST_CASE("Relocation")
+{
+    REQUIRE(IsTriviallyRelocatable<int>::value);
+    REQUIRE(!IsTriviallyRelocatable<OwningObject>::value);
+    REQUIRE(IsTriviallyRelocatable<RelocatableObject>::value);
+    SECTION("Move and destroy")
+    {
+        CheckRelocation<OwningObject>();
+    }
+    SECTION("Trivially relocatable")
+    {
+        CheckRelocation<RelocatableObject>();
+        // Only the temporaries passed to Push/Insert are moved, never the stored elements.
+        REQUIRE(OwningObject::s_Moves == 102);
+    }
+}
+
+struct AllocationCounters
+{
+    int m_Allocations = 0;
+    int m_Frees = 0;
+};
+
+// Counts into whichever AllocationCounters it was constructed with.
+template<typename T>
+struct CountingAllocatorT
+{
+    explicit CountingAllocatorT(AllocationCounters* counters = nullptr) : m_Counters(counters) {}
+    template<typename U>
+    explicit CountingAllocatorT(const CountingAllocatorT<U>& other) : m_Counters(other.m_Counters) {}
+    T* Allocate(uint32_t numItems) { ++m_Counters->m_Allocations; return static_cast<T*>(malloc(sizeof(T) * numItems)); }
+    void Free(T* data)
+    {
+        if (data != nullptr)
+            ++m_Counters->m_Frees;
+        free(data);
+    }
+    AllocationCounters* m_Counters;
+};
+
+TEST_CASE("Stateful allocators")
+{
+    REQUIRE(sizeof(Array<int>) == sizeof(BaseArray<uint16_t, int, DefaultAllocatorT<int>>));
+    REQUIRE(sizeof(Array<int>) <= 2 * sizeof(void*));
+    REQUIRE(sizeof(Array<int, CountingAllocatorT<int>>) > sizeof(Array<int>));
+
+    AllocationCounters a;
+    AllocationCounters b;
+    {
+        typedef BigArray<NonPODObject, CountingAllocatorT<NonPODObject>> CountedArray;
+        CountedArray array1{{1, 2, 3}, CountingAllocatorT<NonPODObject>(&a)};
+        CountedArray array2(4, CountingAllocatorT<NonPODObject>(&b));
+        REQUIRE(a.m_Allocations == 1);
+        REQUIRE(b.m_Allocations == 1);
+
+        CountedArray copy(array1);
+        REQUIRE(copy.GetAllocator().m_Counters == &a);
+        REQUIRE(a.m_Allocations == 2);
+
+        // Copy assignment keeps the destination's allocator.
+        array2 = array1;
+        REQUIRE(array2.GetAllocator().m_Counters == &b);
+        REQUIRE(b.m_Allocations == 1);
+
+        // Move assignment takes the allocator along with the buffer.
+        array2 = std::move(copy);
+        REQUIRE(array2.GetAllocator().m_Counters == &a);
+        REQUIRE(copy.GetAllocator().m_Counters == &b);
+
+        CountedArray moved(std::move(array1));
+        REQUIRE(moved.GetAllocator().m_Counters == &a);
+        REQUIRE(moved.Size() == 3);
+
+        moved.Swap(copy);
+        REQUIRE(copy.GetAllocator().m_Counters == &a);
+        REQUIRE(moved.GetAllocator().m_Counters == &b);
+        REQUIRE(copy.Size() == 3);
+        REQUIRE(copy[2] == 3);
+
+        InplaceArray<int, 2, CountingAllocatorT<int>> inplace{CountingAllocatorT<int>(&b)};
+        inplace.Push({1, 2});
+        REQUIRE(b.m_Allocations == 1);
+        inplace.Push(3);
+        REQUIRE(b.m_Allocations == 2);
+        REQUIRE(inplace.GetAllocator().m_Counters == &b);
+    }
+    REQUIRE(a.m_Allocations == a.m_Frees);
+    REQUIRE(b.m_Allocations == b.m_Frees);
+}
+
+TEST_CASE("Arena allocator")
+{
+    Arena arena(1024);
+    SECTION("Growing the last allocation stays in place")
+    {
+        BigArray<uint32_t, ArenaAllocatorT<uint32_t>> array{ArenaAllocatorT<uint32_t>(arena)};
+        array.Push(0);
+        const uint32_t* buffer = array.GetBuffer();
+        for (uint32_t i = 1; i < 200; ++i)
+            array.Push(i);
+        REQUIRE(array.GetBuffer() == buffer);
+        for (uint32_t i = 0; i < 200; ++i)
+            REQUIRE(array[i] == i);
+    }
+    SECTION("Freeing the last allocation rolls back")
+    {
+        ArenaAllocatorT<uint64_t> allocator(arena);
+        uint64_t* first = allocator.Allocate(4);
+        uint64_t* second = allocator.Allocate(4);
+        allocator.Free(second);
+        REQUIRE(allocator.Allocate(4) == second);
+        allocator.Free(first);
+        REQUIRE(allocator.Allocate(4) != first);
+    }
+    SECTION("Large allocations and Reset")
+    {
+        ArenaAllocatorT<uint8_t> allocator(arena);
+        uint8_t* small = allocator.Allocate(16);
+        uint8_t* large = allocator.Allocate(4096);
+        memset(large, 1, 4096);
+        REQUIRE(large != nullptr);
+        REQUIRE(reinterpret_cast<uintptr_t>(allocator.Allocate(1)) != 0);
+        arena.Reset();
+        REQUIRE(allocator.Allocate(16) != small);
+    }
+    SECTION("Mixed alignments")
+    {
+        // An oversized allocation gets a block of its own size, which leaves the end of
+        // that block unaligned for what follows.
+        Arena small(64);
+        const size_t alignments[] = {1, 8, 64, 2, 16, 4, 32};
+        for (int i = 0; i < 200; ++i)
+        {
+            const size_t alignment = alignments[i % 7];
+            const size_t bytes = static_cast<size_t>(i * 37 % 101) + 1;
+            char* data = static_cast<char*>(small.Allocate(bytes, alignment));
+            REQUIRE(reinterpret_cast<uintptr_t>(data) % alignment == 0);
+            memset(data, i, bytes);
+        }
+        small.Allocate(101, 1);
+        small.Allocate(8, 8);
+        char* aligned = static_cast<char*>(small.Allocate(64, 64));
+        REQUIRE(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+        memset(aligned, 0, 64);
+    }
+    SECTION("Arrays of different types share an arena")
+    {
+        Array<NonPODObject, ArenaAllocatorT<NonPODObject>> objects{ArenaAllocatorT<NonPODObject>(arena)};
+        Array<double, ArenaAllocatorT<double>> doubles{ArenaAllocatorT<double>(arena)};
+        for (int i = 0; i < 100; ++i)
+        {
+            objects.Push(i);
+            doubles.Push(i * 0.5);
+        }
+        REQUIRE(reinterpret_cast<uintptr_t>(doubles.GetBuffer()) % alignof(double) == 0);
+        for (int i = 0; i < 100; ++i)
+        {
+            REQUIRE(objects[i] == i);
+            REQUIRE(doubles[i] == i * 0.5);
+        }
+    }
+}
+
+TEST_CASE("Pool allocator")
+{
+    SECTION("Size classes")
+    {
+        REQUIRE(SizeClassPool::SizeClassFor(1) == 0);
+        REQUIRE(SizeClassPool::SizeClassFor(16) == 0);
+        REQUIRE(SizeClassPool::SizeClassFor(17) == 1);
+        REQUIRE(SizeClassPool::SizeClassFor(SizeClassPool::MAX_BLOCK_SIZE) == SizeClassPool::NUM_CLASSES - 1);
+        REQUIRE(SizeClassPool::SizeClassFor(SizeClassPool::MAX_BLOCK_SIZE + 1) == SizeClassPool::LARGE_CLASS);
+    }
+    SECTION("Blocks are recycled and grow within their class")
+    {
+        uint32_t* first = PoolAllocatorT<uint32_t>::Allocate(5);
+        REQUIRE(reinterpret_cast<uintptr_t>(first) % SizeClassPool::MAX_ALIGNMENT == 0);
+        REQUIRE(PoolAllocatorT<uint32_t>::TryExpand(first, 8));
+        REQUIRE(!PoolAllocatorT<uint32_t>::TryExpand(first, 9));
+        PoolAllocatorT<uint32_t>::Free(first);
+        uint32_t* second = PoolAllocatorT<uint32_t>::Allocate(8);
+        REQUIRE(second == first);
+        PoolAllocatorT<uint32_t>::Free(second);
+        PoolAllocatorT<uint32_t>::Free(nullptr);
+    }
+    SECTION("Arrays")
+    {
+        Array<NonPODObject, PoolAllocatorT<NonPODObject>> small;
+        BigArray<uint8_t, PoolAllocatorT<uint8_t>> large;
+        InplaceArray<int, 4, PoolAllocatorT<int>> inplace;
+        for (int i = 0; i < 100000; ++i)
+        {
+            if (i < 1000)
+            {
+                small.Push(i);
+                inplace.Push(i);
+            }
+            large.Push(static_cast<uint8_t>(i));
+        }
+        for (int i = 0; i < 1000; ++i)
+        {
+            REQUIRE(small[i] == i);
+            REQUIRE(inplace[i] == i);
+        }
+        REQUIRE(large[99999] == static_cast<uint8_t>(99999));
+    }
+    SECTION("Blocks freed on other threads")
+    {
+        std::vector<BigArray<uint64_t, PoolAllocatorT<uint64_t>>> arrays(256);
+        for (uint32_t i = 0; i < arrays.size(); ++i)
+        {
+            for (uint64_t j = 0; j < i; ++j)
+                arrays[i].Push(j);
+        }
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&arrays, t]()
+            {
+                for (uint32_t i = t; i < arrays.size(); i += 4)
+                    arrays[i] = BigArray<uint64_t, PoolAllocatorT<uint64_t>>();
+                for (int i = 0; i < 1000; ++i)
+                {
+                    Array<uint32_t, PoolAllocatorT<uint32_t>> scratch;
+                    for (uint32_t j = 0; j < static_cast<uint32_t>(i % 50); ++j)
+                        scratch.Push(j);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        for (auto& array : arrays)
+            REQUIRE(array.Size() == 0);
+    }
+}
+
+TEST_CASE("InplaceArray copy and move")
+{
+    typedef InplaceArray<NonPODObject, 4, CountingAllocatorT<NonPODObject>> SmallArray;
+    typedef InplaceArray<NonPODObject, 8, CountingAllocatorT<NonPODObject>> LargerArray;
+    AllocationCounters counters;
+    CountingAllocatorT<NonPODObject> allocator(&counters);
+    auto makeArray = [&](int count)
+    {
+        SmallArray array(allocator);
+        for (int i = 0; i < count; ++i)
+            array.Push(i);
+        return array;
+    };
+    {
+        SmallArray source = makeArray(3);
+        source.SetPreserveOrder(true);
+        SmallArray copy(source);
+        SmallArray moved(std::move(source));
+        REQUIRE(counters.m_Allocations == 0);
+        REQUIRE(copy.Size() == 3);
+        REQUIRE(copy.GetPreserveOrder());
+        REQUIRE(moved.Size() == 3);
+        REQUIRE(moved.GetPreserveOrder());
+        REQUIRE(moved[2] == 2);
+        REQUIRE(source.Size() == 0);
+
+        SmallArray assigned;
+        assigned = copy;
+        REQUIRE(assigned[1] == 1);
+        assigned = std::move(moved);
+        REQUIRE(assigned[2] == 2);
+        REQUIRE(counters.m_Allocations == 0);
+
+        // Converting from a larger inline array stays inline when the elements fit.
+        LargerArray larger(allocator);
+        larger.Push({1, 2, 3, 4});
+        SmallArray converted(larger);
+        REQUIRE(counters.m_Allocations == 0);
+        REQUIRE(converted[3] == 4);
+        SmallArray convertedMove(std::move(larger));
+        REQUIRE(counters.m_Allocations == 0);
+        REQUIRE(convertedMove[3] == 4);
+        REQUIRE(larger.Size() == 0);
+    }
+    {
+        // Spilled arrays hand their heap buffer over on move.
+        SmallArray spilled = makeArray(6);
+        REQUIRE(counters.m_Allocations == 1);
+        const NonPODObject* buffer = spilled.GetBuffer();
+        SmallArray moved(std::move(spilled));
+        REQUIRE(counters.m_Allocations == 1);
+        REQUIRE(moved.GetBuffer() == buffer);
+        REQUIRE(moved[5] == 5);
+
+        // Copies only spill when they have to.
+        SmallArray copy(moved);
+        REQUIRE(counters.m_Allocations == 2);
+        REQUIRE(copy[5] == 5);
+        copy = makeArray(2);
+        REQUIRE(counters.m_Frees == 1);
+        REQUIRE(copy.Size() == 2);
+        REQUIRE(copy[1] == 1);
+        REQUIRE(copy.Capacity() == 4);
+
+        SmallArray small = makeArray(2);
+        small = moved;
+        REQUIRE(small.Size() == 6);
+        REQUIRE(small[5] == 5);
+    }
+    REQUIRE(counters.m_Allocations == counters.m_Frees);
+}
+
+TEST_CASE("ShrinkToFit")
+{
+    SECTION("POD")
+    {
+        BigArray<int> array;
+        for (int i = 0; i < 1000; ++i)
+            array.Push(i);
+        array.Resize(10);
+        array.ShrinkToFit();
+        REQUIRE(array.Capacity() == 10);
+        REQUIRE(array[9] == 9);
+        array.ShrinkTo(5);
+        REQUIRE(array.Capacity() == 10);
+        array.Clear();
+        array.ShrinkToFit();
+        REQUIRE(array.Capacity() == 0);
+        REQUIRE(array.GetBuffer() == nullptr);
+        array.Push(1);
+        REQUIRE(array[0] == 1);
+    }
+    SECTION("Non-POD")
+    {
+        OwningObject::s_Live = 0;
+        {
+            Array<OwningObject> array;
+            for (int i = 0; i < 100; ++i)
+                array.Push(OwningObject(i));
+            array.Resize(20);
+            array.ShrinkTo(30);
+            REQUIRE(array.Capacity() == 30);
+            array.ShrinkToFit();
+            REQUIRE(array.Capacity() == 20);
+            REQUIRE(OwningObject::s_Live == 20);
+            for (int i = 0; i < 20; ++i)
+                REQUIRE(array[i] == i);
+        }
+        REQUIRE(OwningObject::s_Live == 0);
+    }
+    SECTION("InplaceArray returns to its inline buffer")
+    {
+        AllocationCounters counters;
+        {
+            InplaceArray<NonPODObject, 8, CountingAllocatorT<NonPODObject>> array{CountingAllocatorT<NonPODObject>(&counters)};
+            const NonPODObject* inlineBuffer = array.GetBuffer();
+            for (int i = 0; i < 100; ++i)
+                array.Push(i);
+            REQUIRE(array.GetBuffer() != inlineBuffer);
+            array.Resize(50);
+            array.ShrinkToFit();
+            REQUIRE(array.Capacity() == 50);
+            REQUIRE(array.GetBuffer() != inlineBuffer);
+            array.Resize(4);
+            array.ShrinkToFit();
+            REQUIRE(array.GetBuffer() == inlineBuffer);
+            REQUIRE(array.Capacity() == 8);
+            REQUIRE(counters.m_Allocations == counters.m_Frees);
+            for (int i = 0; i < 4; ++i)
+                REQUIRE(array[i] == i);
+            array.ShrinkToFit();
+            REQUIRE(array.GetBuffer() == inlineBuffer);
+        }
+        REQUIRE(counters.m_Allocations == counters.m_Frees);
+    }
+}
+
+TEST_CASE("Huge page allocator")
+{
+    typedef HugePageAllocatorT<uint32_t, 64 * 1024> Allocator;
+    SECTION("Small blocks come from the heap")
+    {
+        uint32_t* small = Allocator::Allocate(16);
+        REQUIRE(!HugePageHeap::IsHugeMapped(small));
+        REQUIRE(reinterpret_cast<uintptr_t>(small) % 16 == 0);
+        Allocator::Free(small);
+        Allocator::Free(nullptr);
+    }
+#if defined(__linux__)
+    SECTION("Large blocks are huge page aligned")
+    {
+        uint32_t* large = Allocator::Allocate(64 * 1024);
+        REQUIRE(HugePageHeap::IsHugeMapped(large));
+        REQUIRE(reinterpret_cast<uintptr_t>(large) % HugePageHeap::HUGE_PAGE_SIZE == 0);
+        REQUIRE(Allocator::TryExpand(large, HugePageHeap::HUGE_PAGE_SIZE / sizeof(uint32_t)));
+        REQUIRE(!Allocator::TryExpand(large, HugePageHeap::HUGE_PAGE_SIZE / sizeof(uint32_t) + 1));
+        large[0] = 1;
+        large[64 * 1024 - 1] = 2;
+        large = Allocator::Reallocate(large, HugePageHeap::HUGE_PAGE_SIZE);
+        REQUIRE(reinterpret_cast<uintptr_t>(large) % HugePageHeap::HUGE_PAGE_SIZE == 0);
+        REQUIRE(large[0] == 1);
+        REQUIRE(large[64 * 1024 - 1] == 2);
+        large = Allocator::Reallocate(large, 16);
+        REQUIRE(!HugePageHeap::IsHugeMapped(large));
+        REQUIRE(large[0] == 1);
+        Allocator::Free(large);
+    }
+    SECTION("Running out of address space returns nullptr")
+    {
+        // 4G elements of 64 KB is 256 TB, more than a process can map.
+        struct Page { uint8_t m_Bytes[64 * 1024]; };
+        typedef HugePageAllocatorT<Page> PageAllocator;
+        REQUIRE(PageAllocator::Allocate(0xFFFFFFFF) == nullptr);
+        REQUIRE(PageAllocator::AllocateZeroed(0xFFFFFFFF) == nullptr);
+        Page* pages = PageAllocator::Allocate(64);
+        REQUIRE(pages != nullptr);
+        pages[63].m_Bytes[0] = 7;
+        REQUIRE(PageAllocator::Reallocate(pages, 0xFFFFFFFF) == nullptr);
+        REQUIRE(pages[63].m_Bytes[0] == 7);
+        PageAllocator::Free(pages);
+    }
+#endif
+    SECTION("BigArray crosses the threshold")
+    {
+        BigArray<uint32_t, Allocator> array;
+        for (uint32_t i = 0; i < 2000000; ++i)
+            array.Push(i);
+        bool intact = true;
+        for (uint32_t i = 0; i < 2000000; ++i)
+            intact = intact && array[i] == i;
+        REQUIRE(intact);
+        array.Resize(10);
+        array.ShrinkToFit();
+        REQUIRE(array[9] == 9);
+    }
+}
+
+DECLARE_ALLOCATION_TAG(TelemetryTestTag);
+DECLARE_ALLOCATION_TAG(TelemetryExpandTag);
+
+TEST_CASE("Instrumented allocator")
+{
+    SECTION("Counts allocations, bytes and relocations")
+    {
+        typedef InstrumentedAllocatorT<uint64_t, DefaultAllocatorT<uint64_t>, TelemetryTestTag> Allocator;
+        AllocationStats& stats = Allocator::GetStats();
+        REQUIRE(AllocatorTraits<Allocator, uint64_t>::HasReallocate::value);
+        REQUIRE(!AllocatorTraits<Allocator, uint64_t>::HasTryExpand::value);
+        REQUIRE(AllocatorTraits<Allocator, uint64_t>::HasOnRelocate::value);
+        {
+            BigArray<uint64_t, Allocator, ExactGrowthPolicy> array;
+            array.Reserve(4);
+            array.Push({1, 2, 3, 4});
+            REQUIRE(stats.m_Allocations == 1);
+            REQUIRE(stats.m_LiveBytes == 4 * sizeof(uint64_t));
+            array.Push(5);
+            REQUIRE(stats.m_Reallocations == 1);
+            REQUIRE(stats.m_LiveBytes == 5 * sizeof(uint64_t));
+            REQUIRE(stats.m_PeakBytes == 5 * sizeof(uint64_t));
+            for (uint64_t i = 0; i < 5; ++i)
+                REQUIRE(array[static_cast<uint32_t>(i)] == i + 1);
+            BigArray<uint64_t, Allocator, ExactGrowthPolicy> copy(array);
+            REQUIRE(stats.m_Allocations == 2);
+            REQUIRE(stats.m_PeakBytes == 10 * sizeof(uint64_t));
+        }
+        REQUIRE(stats.m_Frees == 2);
+        REQUIRE(stats.m_LiveBytes == 0);
+        REQUIRE(stats.m_BytesAllocated == 10 * sizeof(uint64_t));
+    }
+    SECTION("Forwards in-place expansion")
+    {
+        typedef InstrumentedAllocatorT<NonPODObject, ExpandableAllocatorT<NonPODObject>, TelemetryExpandTag> Allocator;
+        AllocationStats& stats = Allocator::GetStats();
+        REQUIRE(AllocatorTraits<Allocator, NonPODObject>::HasTryExpand::value);
+        REQUIRE(!AllocatorTraits<Allocator, NonPODObject>::HasReallocate::value);
+        {
+            Array<NonPODObject, Allocator> array;
+            for (int i = 0; i < 300; ++i)
+                array.Push(i);
+            for (int i = 0; i < 300; ++i)
+                REQUIRE(array[i] == i);
+            REQUIRE(stats.m_Allocations == 2);
+            REQUIRE(stats.m_RelocatedElements > 200);
+            REQUIRE(stats.m_RelocatedElements < 300);
+        }
+        REQUIRE(stats.m_LiveBytes == 0);
+    }
+    SECTION("Report")
+    {
+        FILE* file = tmpfile();
+        AllocationTelemetry::Report(file);
+        long length = ftell(file);
+        fclose(file);
+        REQUIRE(length > 0);
+    }
+}
+
+TEST_CASE("Append")
+{
+    SECTION("Pointer range")
+    {
+        Array<int> array{1, 2};
+        const int values[] = {3, 4, 5};
+        array.Append(values, 3);
+        REQUIRE(array.Size() == 5);
+        REQUIRE(array[4] == 5);
+        array.Append(values, values + 2);
+        REQUIRE(array.Size() == 7);
+        REQUIRE(array[6] == 4);
+        array.Append(values, 0);
+        REQUIRE(array.Size() == 7);
+    }
+    SECTION("From itself")
+    {
+        Array<NonPODObject, DefaultAllocatorT<NonPODObject>, ExactGrowthPolicy> array{1, 2, 3};
+        array.Append(array);
+        REQUIRE(array.Size() == 6);
+        REQUIRE(array[3] == 1);
+        REQUIRE(array[5] == 3);
+        array.Append(array.begin() + 1, array.begin() + 3);
+        REQUIRE(array.Size() == 8);
+        REQUIRE(array[6] == 2);
+        REQUIRE(array[7] == 3);
+    }
+    SECTION("Across count types")
+    {
+        BigArray<uint32_t> big{1, 2, 3};
+        Array<uint32_t> small{0};
+        small.Append(big);
+        REQUIRE(small.Size() == 4);
+        REQUIRE(small[3] == 3);
+        big.Append(small);
+        REQUIRE(big.Size() == 7);
+        REQUIRE(big[6] == 3);
+        InplaceArray<uint32_t, 4> inplace;
+        inplace.Append(small);
+        REQUIRE(inplace.Size() == 4);
+    }
+    SECTION("Iterator ranges reserve once")
+    {
+        AllocationCounters counters;
+        std::vector<int> vector{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        Array<NonPODObject, CountingAllocatorT<NonPODObject>> array{CountingAllocatorT<NonPODObject>(&counters)};
+        array.Append(vector.begin(), vector.end());
+        REQUIRE(counters.m_Allocations == 1);
+        REQUIRE(array.Capacity() == 10);
+        REQUIRE(array[9] == 10);
+
+        std::list<int> list{11, 12};
+        array.Append(list.begin(), list.end());
+        REQUIRE(counters.m_Allocations == 2);
+        REQUIRE(array.Size() == 12);
+        REQUIRE(array[11] == 12);
+    }
+    SECTION("Non-POD copies")
+    {
+        OwningObject::s_Live = 0;
+        {
+            Array<OwningObject> source;
+            for (int i = 0; i < 10; ++i)
+                source.Push(OwningObject(i));
+            Array<OwningObject> array;
+            array.Append(source);
+            array.Append(source.GetBuffer(), 5);
+            REQUIRE(array.Size() == 15);
+            REQUIRE(array[14] == 4);
+            REQUIRE(OwningObject::s_Live == 25);
+        }
+        REQUIRE(OwningObject::s_Live == 0);
+    }
+}
+
+// Counts zeroed allocations, which it serves with calloc.
+template<typename T>
+struct ZeroingAllocatorT : DefaultAllocatorT<T>
+{
+    static T* AllocateZeroed(uint32_t numItems) { ++s_ZeroedAllocations; return DefaultAllocatorT<T>::AllocateZeroed(numItems); }
+    static int s_ZeroedAllocations;
+};
+template<typename T> int ZeroingAllocatorT<T>::s_ZeroedAllocations = 0;
+
+template<typename ArrayType>
+static bool AllZero(const ArrayType& array)
+{
+    for (auto value : array)
+    {
+        if (value != 0)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE("Zeroed and uninitialized resize")
+{
+    REQUIRE(AllocatorTraits<DefaultAllocatorT<int>, int>::HasAllocateZeroed::value);
+    REQUIRE(!AllocatorTraits<ExpandableAllocatorT<int>, int>::HasAllocateZeroed::value);
+
+    SECTION("Fresh growth uses the allocator")
+    {
+        ZeroingAllocatorT<uint32_t>::s_ZeroedAllocations = 0;
+        BigArray<uint32_t, ZeroingAllocatorT<uint32_t>> array;
+        array.ResizeZeroed(100000);
+        REQUIRE(ZeroingAllocatorT<uint32_t>::s_ZeroedAllocations == 1);
+        REQUIRE(array.Size() == 100000);
+        REQUIRE(AllZero(array));
+
+        array.Clear();
+        array.ResizeZeroed(200000);
+        REQUIRE(ZeroingAllocatorT<uint32_t>::s_ZeroedAllocations == 2);
+        REQUIRE(AllZero(array));
+    }
+    SECTION("Growth keeps existing elements")
+    {
+        ZeroingAllocatorT<int>::s_ZeroedAllocations = 0;
+        Array<int, ZeroingAllocatorT<int>> array{1, 2, 3};
+        array.ResizeZeroed(1000);
+        REQUIRE(ZeroingAllocatorT<int>::s_ZeroedAllocations == 0);
+        REQUIRE(array[2] == 3);
+        REQUIRE(array[3] == 0);
+        REQUIRE(array[999] == 0);
+
+        // Slots within capacity that held values are cleared too.
+        array.Resize(2);
+        array.ResizeZeroed(3);
+        REQUIRE(array[1] == 2);
+        REQUIRE(array[2] == 0);
+        array.ResizeZeroed(1);
+        REQUIRE(array.Size() == 1);
+    }
+    SECTION("Allocators without the hook")
+    {
+        BigArray<double, ExpandableAllocatorT<double>> array;
+        array.ResizeZeroed(100);
+        REQUIRE(AllZero(array));
+        InplaceArray<uint64_t, 4> inplace;
+        inplace.ResizeZeroed(3);
+        REQUIRE(inplace.Capacity() == 4);
+        REQUIRE(AllZero(inplace));
+        inplace.ResizeZeroed(50);
+        REQUIRE(AllZero(inplace));
+    }
+    SECTION("Huge pages")
+    {
+        BigArray<uint64_t, HugePageAllocatorT<uint64_t>> array;
+        array.ResizeZeroed(1024 * 1024);
+        REQUIRE(HugePageHeap::IsHugeMapped(array.GetBuffer()));
+        REQUIRE(AllZero(array));
+        BigArray<uint64_t, HugePageAllocatorT<uint64_t>> small;
+        small.ResizeZeroed(100);
+        REQUIRE(!HugePageHeap::IsHugeMapped(small.GetBuffer()));
+        REQUIRE(AllZero(small));
+    }
+    SECTION("Instrumented")
+    {
+        typedef InstrumentedAllocatorT<uint16_t> Allocator;
+        const uint64_t allocations = Allocator::GetStats().m_Allocations;
+        {
+            Array<uint16_t, Allocator> array;
+            array.ResizeZeroed(5000);
+            REQUIRE(AllZero(array));
+        }
+        REQUIRE(Allocator::GetStats().m_Allocations == allocations + 1);
+    }
+    SECTION("Uninitialized")
+    {
+        BigArray<uint8_t> array;
+        array.ResizeUninitialized(4096);
+        REQUIRE(array.Size() == 4096);
+        memset(array.GetBuffer(), 7, array.Size());
+        array.ResizeUninitialized(10);
+        REQUIRE(array.Size() == 10);
+        REQUIRE(array[9] == 7);
+    }
+}
+
+// Fails every allocation larger than s_MaxItems.
+template<typename T>
+struct LimitedAllocatorT : DefaultAllocatorT<T>
+{
+    static T* Allocate(uint32_t numItems) { return numItems > s_MaxItems ? nullptr : DefaultAllocatorT<T>::Allocate(numItems); }
+    static T* Reallocate(T* data, uint32_t numItems) { return numItems > s_MaxItems ? nullptr : DefaultAllocatorT<T>::Reallocate(data, numItems); }
+    static uint32_t s_MaxItems;
+};
+template<typename T> uint32_t LimitedAllocatorT<T>::s_MaxItems = 8;
+
+struct EmplacedObject : OwningObject
+{
+    EmplacedObject(int x, int y) : OwningObject(x * 100 + y) {}
+};
+
+TEST_CASE("Emplace")
+{
+    OwningObject::s_Live = 0;
+    OwningObject::s_Moves = 0;
+    SECTION("Constructs in place")
+    {
+        {
+            Array<EmplacedObject> array;
+            array.Reserve(3);
+            EmplacedObject& first = array.Emplace(1, 2);
+            REQUIRE(&first == array.GetBuffer());
+            array.Emplace(3, 4);
+            REQUIRE(OwningObject::s_Moves == 0);
+            // Only the shifted elements are moved.
+            REQUIRE(array.EmplaceAt(0, 5, 6) == 506);
+            REQUIRE(OwningObject::s_Moves == 2);
+            REQUIRE(array[1] == 102);
+            REQUIRE(array[2] == 304);
+            array.EmplaceAt(3, 7, 8);
+            REQUIRE(array.Size() == 4);
+            REQUIRE(array[3] == 708);
+        }
+        REQUIRE(OwningObject::s_Live == 0);
+    }
+    SECTION("Copy and move arguments")
+    {
+        Array<OwningObject> array;
+        OwningObject value(7);
+        array.Emplace(value);
+        array.Emplace(std::move(value));
+        array.Emplace();
+        REQUIRE(array[0] == 7);
+        REQUIRE(array[1] == 7);
+        REQUIRE(array[2] == 0);
+        REQUIRE(OwningObject::s_Moves == 1);
+    }
+    SECTION("TryEmplace")
+    {
+        Array<int, LimitedAllocatorT<int>, ExactGrowthPolicy> array;
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(array.TryEmplace(i) != nullptr);
+        REQUIRE(array.TryEmplace(8) == nullptr);
+        REQUIRE(array.Size() == 8);
+        REQUIRE(array.Capacity() == 8);
+        REQUIRE(array[7] == 7);
+
+        Array<OwningObject, LimitedAllocatorT<OwningObject>, ExactGrowthPolicy> objects;
+        for (int i = 0; i < 8; ++i)
+            REQUIRE(*objects.TryEmplace(i) == i);
+        REQUIRE(objects.TryEmplace(8) == nullptr);
+        REQUIRE(OwningObject::s_Live == 8);
+    }
+    SECTION("TryEmplace past the count type")
+    {
+        Array<uint8_t> array;
+        array.ResizeZeroed(std::numeric_limits<uint16_t>::max() - 1);
+        REQUIRE(array.TryEmplace(static_cast<uint8_t>(1)) == nullptr);
+        REQUIRE(array.Size() == std::numeric_limits<uint16_t>::max() - 1);
+    }
+}
+
+// Compares RemoveValues on random data against std::remove, for every remainder length
+// the vector kernels can leave.
+template<typename T>
+void CheckRemoveValues()
+{
+    uint32_t state = 12345;
+    for (uint32_t size = 0; size < 300; size += 7)
+    {
+        for (uint32_t range = 1; range <= 5; range += 2)
+        {
+            BigArray<T> array;
+            std::vector<T> expected;
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                state = state * 1103515245 + 12345;
+                const T value = static_cast<T>((state >> 16) % range);
+                array.Push(value);
+                expected.push_back(value);
+            }
+            const T value = static_cast<T>(range / 2);
+            expected.erase(std::remove(expected.begin(), expected.end(), value), expected.end());
+            REQUIRE(array.RemoveValues(value) == size - expected.size());
+            REQUIRE(array.Size() == expected.size());
+            REQUIRE(std::equal(expected.begin(), expected.end(), array.begin()));
+        }
+    }
+}
+
+TEST_CASE("RemoveIf")
+{
+    SECTION("Preserve order")
+    {
+        OwningObject::s_Live = 0;
+        {
+            Array<OwningObject> array;
+            for (int i = 0; i < 100; ++i)
+                array.Emplace(i);
+            array.SetPreserveOrder(true);
+            REQUIRE(array.RemoveIf([](int value) { return value % 3 != 0; }) == 66);
+            REQUIRE(array.Size() == 34);
+            for (int i = 0; i < 34; ++i)
+                REQUIRE(array[i] == i * 3);
+            REQUIRE(OwningObject::s_Live == 34);
+            REQUIRE(array.RemoveIf([](int) { return false; }) == 0);
+            REQUIRE(array.RemoveIf([](int) { return true; }) == 34);
+        }
+        REQUIRE(OwningObject::s_Live == 0);
+    }
+    SECTION("Unordered")
+    {
+        OwningObject::s_Live = 0;
+        {
+            Array<OwningObject> array;
+            for (int i = 0; i < 10; ++i)
+                array.Emplace(i);
+            OwningObject::s_Moves = 0;
+            int calls = 0;
+            REQUIRE(array.RemoveIf([&calls](int value) { ++calls; return value == 1 || value == 2 || value == 9; }) == 3);
+            REQUIRE(calls == 10);
+            // The holes at 1 and 2 are filled by 8 and 7.
+            REQUIRE(OwningObject::s_Moves == 2);
+            int expected[] = {0, 8, 7, 3, 4, 5, 6};
+            REQUIRE(array.Size() == 7);
+            REQUIRE(std::equal(array.begin(), array.end(), expected));
+            REQUIRE(OwningObject::s_Live == 7);
+        }
+        REQUIRE(OwningObject::s_Live == 0);
+    }
+    SECTION("RemoveValues")
+    {
+        Array<NonPODObject> objects{1, 2, 1, 3};
+        REQUIRE(objects.RemoveValues(NonPODObject(1)) == 2);
+        REQUIRE(objects.Size() == 2);
+        CheckRemoveValues<uint8_t>();
+        CheckRemoveValues<int16_t>();
+        CheckRemoveValues<uint32_t>();
+        CheckRemoveValues<int64_t>();
+        CheckRemoveValues<float>();
+        CheckRemoveValues<double>();
+    }
+    SECTION("Floating point equality")
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        BigArray<float> array;
+        for (int i = 0; i < 20; ++i)
+            array.Push(i % 2 ? -0.0f : nan);
+        REQUIRE(array.RemoveValues(0.0f) == 10);
+        REQUIRE(array.RemoveValues(nan) == 0);
+        REQUIRE(array.Size() == 10);
+    }
+}
+
+template<typename T>
+void CheckRanges()
+{
+    OwningObject::s_Live = 0;
+    {
+        Array<T> array;
+        for (int i = 0; i < 10; ++i)
+            array.Push(T(i));
+        const T values[] = {T(100), T(101), T(102)};
+        array.InsertRange(2, values, 3);
+        array.InsertRange(array.Size(), values, 1);
+        int expected[] = {0, 1, 100, 101, 102, 2, 3, 4, 5, 6, 7, 8, 9, 100};
+        REQUIRE(array.Size() == 14);
+        REQUIRE(std::equal(array.begin(), array.end(), expected));
+
+        array.SetPreserveOrder(true);
+        array.RemoveRange(2, 3);
+        array.RemoveRange(10, 1);
+        array.RemoveRange(0, 0);
+        REQUIRE(array.Size() == 10);
+        for (int i = 0; i < 10; ++i)
+            REQUIRE(array[i] == i);
+
+        // Without preserve order the last elements fill the hole.
+        array.SetPreserveOrder(false);
+        array.RemoveRange(1, 2);
+        int unordered[] = {0, 8, 9, 3, 4, 5, 6, 7};
+        REQUIRE(std::equal(array.begin(), array.end(), unordered));
+        array.RemoveRange(5, 3);
+        REQUIRE(array.Size() == 5);
+        REQUIRE(array[4] == 4);
+
+        Array<T> other;
+        other.InsertRange(0, array);
+        other.InsertRange(0, array);
+        REQUIRE(other.Size() == 10);
+        REQUIRE(other[5] == 0);
+        if (std::is_base_of<OwningObject, T>::value)
+            REQUIRE(OwningObject::s_Live == 5 + 10 + 3);
+        other.RemoveRange(0, 10);
+        REQUIRE(other.Empty());
+    }
+    REQUIRE(OwningObject::s_Live == 0);
+}
+
+TEST_CASE("Range insert and remove")
+{
+    SECTION("POD")
+    {
+        CheckRanges<int>();
+    }
+    SECTION("Non-POD")
+    {
+        CheckRanges<NonPODObject>();
+        CheckRanges<OwningObject>();
+        CheckRanges<RelocatableObject>();
+    }
+    SECTION("From itself")
+    {
+        // Sources before, across and after the insertion point, into a full array and into
+        // one with room to spare.
+        for (int offset = 0; offset < 8; ++offset)
+        {
+            for (int count = 1; offset + count <= 8; ++count)
+            {
+                for (uint16_t capacity : {8, 16})
+                {
+                    Array<NonPODObject, DefaultAllocatorT<NonPODObject>, ExactGrowthPolicy> array{0, 1, 2, 3, 4, 5, 6, 7};
+                    array.Reserve(capacity);
+                    std::vector<int> expected{0, 1, 2, 3, 4, 5, 6, 7};
+                    expected.insert(expected.begin() + 4, expected.begin() + offset, expected.begin() + offset + count);
+                    array.InsertRange(4, array.GetBuffer() + offset, static_cast<uint16_t>(count));
+                    REQUIRE(array.Size() == expected.size());
+                    REQUIRE(std::equal(expected.begin(), expected.end(), array.begin()));
+                }
+            }
+        }
+    }
+    SECTION("Across count types")
+    {
+        BigArray<uint32_t> big{1, 2, 3};
+        InplaceArray<uint32_t, 4> inplace{};
+        inplace.Push({10, 20});
+        inplace.InsertRange(1, big);
+        uint32_t expected[] = {10, 1, 2, 3, 20};
+        REQUIRE(std::equal(inplace.begin(), inplace.end(), expected));
+    }
+}
+
+// Plants value at every position of arrays of every length up to a few vector widths and
+// checks the search results against a plain loop.
+template<typename T>
+void CheckFind()
+{
+    for (uint16_t size = 0; size < 150; ++size)
+    {
+        Array<T> array;
+        for (uint16_t i = 0; i < size; ++i)
+            array.Push(static_cast<T>(i % 7 + 1));
+        REQUIRE(array.IndexOf(static_cast<T>(0)) == Array<T>::INVALID_INDEX);
+        REQUIRE(array.Find(static_cast<T>(0)) == nullptr);
+        REQUIRE(array.Count(static_cast<T>(0)) == 0);
+        REQUIRE(array.Count(static_cast<T>(3)) == (size + 4) / 7);
+        for (uint16_t position = 0; position < size; position += 5)
+        {
+            const T saved = array[position];
+            array[position] = 0;
+            REQUIRE(array.IndexOf(static_cast<T>(0)) == position);
+            REQUIRE(array.Find(static_cast<T>(0)) == &array[position]);
+            REQUIRE(array.Contains(static_cast<T>(0)));
+            REQUIRE(array.Count(static_cast<T>(0)) == 1);
+            array[position] = saved;
+        }
+    }
+}
+
+TEST_CASE("Find")
+{
+    SECTION("Arithmetic types")
+    {
+        CheckFind<int8_t>();
+        CheckFind<uint16_t>();
+        CheckFind<int32_t>();
+        CheckFind<uint64_t>();
+        CheckFind<float>();
+        CheckFind<double>();
+    }
+    SECTION("Floating point equality")
+    {
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        BigArray<double> array;
+        for (int i = 0; i < 40; ++i)
+            array.Push(i == 33 ? -0.0 : nan);
+        REQUIRE(array.IndexOf(0.0) == 33);
+        REQUIRE(!array.Contains(nan));
+        REQUIRE(array.Count(nan) == 0);
+    }
+    SECTION("Other types")
+    {
+        const Array<NonPODObject> array{4, 5, 4};
+        REQUIRE(array.IndexOf(NonPODObject(5)) == 1);
+        REQUIRE(array.Find(NonPODObject(4)) == array.GetBuffer());
+        REQUIRE(!array.Contains(NonPODObject(6)));
+        REQUIRE(array.Count(NonPODObject(4)) == 2);
+    }
+    SECTION("Remove")
+    {
+        BigArray<uint32_t> array;
+        for (uint32_t i = 0; i < 100; ++i)
+            array.Push(i);
+        array.SetPreserveOrder(true);
+        REQUIRE(array.Remove(70));
+        REQUIRE(!array.Remove(70));
+        REQUIRE(array.Size() == 99);
+        REQUIRE(array[70] == 71);
+    }
+}
+
+enum class Color : uint8_t { Red, Green, Blue };
+
+TEST_CASE("Comparison")
+{
+    REQUIRE(IsBitwiseComparable<uint32_t>::value);
+    REQUIRE(IsBitwiseComparable<Color>::value);
+    REQUIRE(!IsBitwiseComparable<float>::value);
+    REQUIRE(!IsBitwiseComparable<NonPODObject>::value);
+
+    SECTION("Bitwise comparable")
+    {
+        BigArray<uint32_t> a;
+        for (uint32_t i = 0; i < 1000; ++i)
+            a.Push(i);
+        Array<uint32_t> b;
+        b.Append(a);
+        REQUIRE(a == b);
+        REQUIRE(a.Compare(b) == 0);
+        // Differences in every position of a vector, and in the high byte of an element
+        // whose low bytes already differ the other way.
+        for (uint16_t i = 0; i < 1000; i += 37)
+        {
+            b[i] += 1;
+            REQUIRE(a != b);
+            REQUIRE(a.Compare(b) < 0);
+            REQUIRE(b.Compare(a) > 0);
+            REQUIRE(a < b);
+            REQUIRE(b >= a);
+            b[i] -= 1;
+        }
+        b[500] = 0x100;
+        a[500] = 0xFF;
+        REQUIRE(a < b);
+        b.Pop();
+        REQUIRE(a.Compare(b) < 0);
+        REQUIRE(b > a);
+
+        Array<Color> colors{Color::Red, Color::Blue};
+        Array<Color> others{Color::Red, Color::Green};
+        REQUIRE(colors != others);
+        REQUIRE(colors > others);
+    }
+    SECTION("Prefixes and empty arrays")
+    {
+        Array<int> empty;
+        Array<int> shorter{1, 2};
+        Array<int> longer{1, 2, 0};
+        REQUIRE(empty == Array<int>());
+        REQUIRE(empty.Compare(Array<int>()) == 0);
+        REQUIRE(empty < shorter);
+        REQUIRE(shorter < longer);
+        REQUIRE(longer <= longer);
+        REQUIRE(Array<int>{-1} < Array<int>{0});
+    }
+    SECTION("Element-wise types")
+    {
+        Array<float> zeros{0.0f, 1.0f};
+        Array<float> negativeZeros{-0.0f, 1.0f};
+        REQUIRE(zeros == negativeZeros);
+        REQUIRE(zeros.Compare(negativeZeros) == 0);
+        Array<NonPODObject> a{1, 2, 3};
+        Array<NonPODObject> b{1, 3};
+        REQUIRE(a != b);
+        REQUIRE(a < b);
+    }
+    SECTION("Move-only elements")
+    {
+        Array<std::unique_ptr<int>> a;
+        Array<std::unique_ptr<int>> b;
+        REQUIRE(a == b);
+        a.Emplace(new int(1));
+        REQUIRE(a != b);
+    }
+}
+
+TEST_CASE("Check policies")
+{
+    REQUIRE(std::is_same<DefaultCheckPolicy, AssertCheckPolicy>::value);
+    REQUIRE(sizeof(Array<int, DefaultAllocatorT<int>, DefaultGrowthPolicy, NoCheckPolicy>) == sizeof(Array<int>));
+
+    Array<int, DefaultAllocatorT<int>, DefaultGrowthPolicy, NoCheckPolicy> unchecked{1, 2, 3};
+    BigArray<int, DefaultAllocatorT<int>, DefaultGrowthPolicy, TrapCheckPolicy> trapping{1, 2, 3};
+    InplaceArray<int, 4, DefaultAllocatorT<int>, DefaultGrowthPolicy, NoCheckPolicy> inplace;
+    inplace.Append(trapping);
+    REQUIRE(unchecked == trapping);
+    REQUIRE(inplace == unchecked);
+    REQUIRE(unchecked.First() == 1);
+    REQUIRE(trapping.Last() == 3);
+    trapping.Pop();
+    REQUIRE(trapping < unchecked);
+
+    Array<int> checked{4, 5};
+    REQUIRE(checked.Unchecked(1) == 5);
+    checked.Unchecked(0) = 6;
+    const Array<int>& constChecked = checked;
+    REQUIRE(constChecked.Unchecked(0) == 6);
+    // Reading into spare capacity is fine without checks.
+    checked.Reserve(8);
+    checked.Unchecked(7) = 9;
+    REQUIRE(checked.Size() == 2);
+}
+
+template<typename SetType, typename T>
+static bool SameElements(const SetType& sorted, const std::set<T>& expected)
+{
+    return sorted.Size() == expected.size() && std::equal(sorted.begin(), sorted.end(), expected.begin());
+}
+
+TEST_CASE("SortedArray")
+{
+    // Insert, Remove and LowerBound against std::set
+    {
+        SortedArray<uint32_t> sorted;
+        std::set<uint32_t> expected;
+        uint32_t seed = 1;
+        for (int i = 0; i < 2000; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            const uint32_t value = (seed >> 16) % 500;
+            if (i % 3 == 2)
+                REQUIRE(sorted.Remove(value) == (expected.erase(value) == 1));
+            else
+                REQUIRE(sorted.Insert(value) == expected.insert(value).second);
+        }
+        REQUIRE(SameElements(sorted, expected));
+        for (uint32_t value = 0; value < 510; ++value)
+        {
+            const uint32_t index = sorted.LowerBound(value);
+            REQUIRE(index == static_cast<uint32_t>(std::distance(expected.begin(), expected.lower_bound(value))));
+            REQUIRE(sorted.Contains(value) == (expected.count(value) == 1));
+            REQUIRE((sorted.Find(value) != nullptr) == (expected.count(value) == 1));
+        }
+        SortedArray<uint32_t> empty;
+        REQUIRE(empty.LowerBound(7) == 0);
+        REQUIRE(!empty.Contains(7));
+    }
+
+    // Merge skips duplicates within the batch and values already present
+    {
+        SortedArray<int> sorted;
+        BigArray<int> batch = { 5, 10, 15 };
+        sorted.Merge(batch);
+        REQUIRE(sorted.Size() == 3);
+        const int more[] = { 1, 5, 5, 7, 15, 20, 20 };
+        sorted.Merge(more, 7);
+        std::set<int> expected = { 1, 5, 7, 10, 15, 20 };
+        REQUIRE(SameElements(sorted, expected));
+        const uint32_t capacity = sorted.Capacity();
+        sorted.Merge(more, 7);
+        REQUIRE(SameElements(sorted, expected));
+        REQUIRE(sorted.Capacity() == capacity);
+        sorted.Merge(more, 0);
+        REQUIRE(SameElements(sorted, expected));
+    }
+
+    // Random merges, including non-trivial elements
+    {
+        SortedArray<std::string> sorted;
+        std::set<std::string> expected;
+        uint32_t seed = 7;
+        for (int round = 0; round < 20; ++round)
+        {
+            std::vector<std::string> batch;
+            for (int i = 0; i < 40; ++i)
+            {
+                seed = seed * 1103515245u + 12345u;
+                batch.push_back(std::to_string((seed >> 16) % 300));
+            }
+            std::sort(batch.begin(), batch.end());
+            sorted.Merge(batch.data(), static_cast<uint32_t>(batch.size()));
+            expected.insert(batch.begin(), batch.end());
+            REQUIRE(SameElements(sorted, expected));
+        }
+        REQUIRE(sorted.Remove("17") == (expected.erase("17") == 1));
+        REQUIRE(SameElements(sorted, expected));
+    }
+
+    // The search layout answers like the sorted storage for every tree shape, and
+    // mutations drop it
+    {
+        for (uint32_t size = 0; size < 70; ++size)
+        {
+            SortedArray<int> sorted;
+            for (uint32_t i = 0; i < size; ++i)
+                sorted.Insert(static_cast<int>(2 * i));
+            sorted.BuildSearchLayout();
+            REQUIRE(sorted.HasSearchLayout() == (size > 0));
+            for (int value = -1; value <= static_cast<int>(2 * size); ++value)
+                REQUIRE(sorted.Contains(value) == (value >= 0 && value % 2 == 0 && value < static_cast<int>(2 * size)));
+        }
+        SortedArray<int, std::greater<int>> descending;
+        const int values[] = { 9, 6, 3 };
+        descending.Merge(values, 3);
+        descending.BuildSearchLayout();
+        REQUIRE(descending.Contains(6));
+        REQUIRE(!descending.Contains(5));
+        REQUIRE(descending.LowerBound(5) == 2);
+        descending.Insert(5);
+        REQUIRE(!descending.HasSearchLayout());
+        REQUIRE(descending.Contains(5));
+        descending.BuildSearchLayout();
+        REQUIRE(descending.Contains(5));
+        descending.DropSearchLayout();
+        REQUIRE(!descending.HasSearchLayout());
+        REQUIRE(descending.Contains(9));
+    }
+}
+
+// Sends every key to the same group, so lookups have to probe past full groups.
+struct CollidingHash
+{
+    size_t operator()(uint32_t) const { return 42; }
+};
+
+template<typename MapType, typename KeyType, typename ValueType>
+static bool SameEntries(const MapType& map, const std::unordered_map<KeyType, ValueType>& expected)
+{
+    if (map.Size() != expected.size())
+        return false;
+    uint32_t visited = 0;
+    for (const typename MapType::Entry& entry : map)
+    {
+        auto found = expected.find(entry.m_Key);
+        if (found == expected.end() || !(found->second == entry.m_Value))
+            return false;
+        ++visited;
+    }
+    return visited == expected.size();
+}
+
+TEST_CASE("Flat hash map and set")
+{
+    // The portable mix matches the 128 bit multiply
+    {
+        uint64_t value = 1;
+        for (int i = 0; i < 1000; ++i)
+        {
+            REQUIRE(FlatHashMix::Mix(value) == FlatHashMix::MixPortable(value));
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+        }
+        REQUIRE(FlatHashMix::Mix(~0ull) == FlatHashMix::MixPortable(~0ull));
+        REQUIRE(FlatHashMix::Mix(0) == 0);
+    }
+
+    // Random inserts and removes against std::unordered_map, with tombstones reused
+    {
+        FlatHashMap<uint32_t, uint32_t> map;
+        std::unordered_map<uint32_t, uint32_t> expected;
+        uint32_t seed = 3;
+        for (int i = 0; i < 20000; ++i)
+        {
+            seed = seed * 1103515245u + 12345u;
+            const uint32_t key = (seed >> 16) % 3000;
+            if (i % 3 == 2)
+                REQUIRE(map.Remove(key) == (expected.erase(key) == 1));
+            else
+                REQUIRE(map.Insert(key, i) == expected.emplace(key, i).second);
+        }
+        REQUIRE(SameEntries(map, expected));
+        for (uint32_t key = 0; key < 3100; ++key)
+        {
+            const uint32_t* value = map.Find(key);
+            REQUIRE((value != nullptr) == (expected.count(key) == 1));
+            if (value != nullptr)
+                REQUIRE(*value == expected[key]);
+        }
+        map[5000] += 7;
+        map[5000] += 7;
+        REQUIRE(*map.Find(5000) == 14);
+        map.Clear();
+        REQUIRE(map.Empty());
+        REQUIRE(!map.Contains(5000));
+        REQUIRE(map.begin() == map.end());
+    }
+
+    // Non-trivial keys and values survive growth, copies and moves
+    {
+        FlatHashMap<std::string, std::string> map;
+        std::unordered_map<std::string, std::string> expected;
+        for (int i = 0; i < 500; ++i)
+        {
+            map.Insert(std::to_string(i), std::string(i % 40, 'x'));
+            expected.emplace(std::to_string(i), std::string(i % 40, 'x'));
+        }
+        for (int i = 0; i < 500; i += 3)
+        {
+            map.Remove(std::to_string(i));
+            expected.erase(std::to_string(i));
+        }
+        REQUIRE(SameEntries(map, expected));
+        FlatHashMap<std::string, std::string> copy(map);
+        REQUIRE(SameEntries(copy, expected));
+        FlatHashMap<std::string, std::string> moved(std::move(copy));
+        REQUIRE(SameEntries(moved, expected));
+        REQUIRE(copy.Empty());
+        copy = moved;
+        REQUIRE(SameEntries(copy, expected));
+        moved.Clear();
+        REQUIRE(moved.Empty());
+    }
+
+    // Colliding keys probe across groups
+    {
+        FlatHashMap<uint32_t, uint32_t, CollidingHash> map;
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(map.Insert(i, i * 2));
+        for (uint32_t i = 0; i < 100; i += 2)
+            REQUIRE(map.Remove(i));
+        for (uint32_t i = 0; i < 110; ++i)
+            REQUIRE(map.Contains(i) == (i < 100 && i % 2 == 1));
+        REQUIRE(*map.Find(99) == 198);
+    }
+
+    // Reserve and bulk build
+    {
+        FlatHashMap<uint32_t, uint32_t> map;
+        map.Reserve(1000);
+        const uint32_t capacity = map.Capacity();
+        REQUIRE(capacity >= 1000);
+        BigArray<uint32_t> keys;
+        BigArray<uint32_t> values;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            keys.Push(i * 7919);
+            values.Push(i);
+        }
+        keys.Push(0);
+        values.Push(12345);
+        map.InsertRange(keys, values);
+        REQUIRE(map.Capacity() == capacity);
+        REQUIRE(map.Size() == 1000);
+        REQUIRE(*map.Find(0) == 0);
+        REQUIRE(*map.Find(999 * 7919) == 999);
+
+        FlatHashSet<uint32_t> set;
+        set.InsertRange(keys);
+        REQUIRE(set.Size() == 1000);
+        REQUIRE(set.Contains(7919));
+        REQUIRE(!set.Insert(7919));
+        REQUIRE(set.Remove(7919));
+        REQUIRE(!set.Contains(7919));
+        uint32_t visited = 0;
+        for (uint32_t key : set)
+            visited += key % 7919 == 0;
+        REQUIRE(visited == 999);
+    }
+
+    // The allocator is rebound for control bytes and slots, keeping its state
+    {
+        Arena arena;
+        FlatHashSet<uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, ArenaAllocatorT<uint32_t>> set{ArenaAllocatorT<uint32_t>(arena)};
+        for (uint32_t i = 0; i < 100; ++i)
+            set.Insert(i);
+        REQUIRE(set.Size() == 100);
+        REQUIRE(set.Contains(99));
+
+        FlatHashMap<uint32_t, uint32_t, std::hash<uint32_t>, std::equal_to<uint32_t>, InstrumentedAllocatorT<uint32_t>> map;
+        map.Insert(1, 2);
+        REQUIRE(*map.Find(1) == 2);
+        REQUIRE(InstrumentedAllocatorT<uint8_t>::GetStats().m_Allocations.load() > 0);
+    }
+}
+
+template<size_t I, typename SoaType>
+static bool ColumnAligned(const SoaType& soa)
+{
+    return reinterpret_cast<uintptr_t>(soa.template Column<I>().GetBuffer()) % SoaType::COLUMN_ALIGNMENT == 0;
+}
+
+TEST_CASE("SoaArray")
+{
+    // One capacity for all columns, each column aligned
+    {
+        BigSoaArray<float, float, float, uint32_t> particles;
+        for (uint32_t i = 0; i < 1000; ++i)
+            particles.Push(i * 1.0f, i * 2.0f, i * 3.0f, i);
+        REQUIRE(particles.Size() == 1000);
+        REQUIRE(particles.Capacity() >= 1000);
+        REQUIRE(ColumnAligned<0>(particles));
+        REQUIRE(ColumnAligned<1>(particles));
+        REQUIRE(ColumnAligned<2>(particles));
+        REQUIRE(ColumnAligned<3>(particles));
+        ArraySpan<float> y = particles.Column<1>();
+        REQUIRE(y.Size() == 1000);
+        float sum = 0.0f;
+        for (float value : y)
+            sum += value;
+        REQUIRE(sum == 999000.0f);
+        ArraySpan<uint32_t> ids = particles.Column<3>();
+        for (uint32_t i = 0; i < ids.Size(); ++i)
+            REQUIRE(ids[i] == i);
+        REQUIRE(particles.Get<2>(10) == 30.0f);
+        particles.Get<2>(10) = 5.0f;
+        REQUIRE(particles.Column<2>()[10] == 5.0f);
+    }
+
+    // Small blocks usually aren't aligned to a column, so every growth needs its own slack
+    {
+        BigSoaArray<uint8_t, uint64_t> rows;
+        for (uint32_t i = 0; i < 100; ++i)
+        {
+            rows.Push(static_cast<uint8_t>(i), i);
+            REQUIRE(ColumnAligned<0>(rows));
+            REQUIRE(ColumnAligned<1>(rows));
+        }
+        for (uint32_t i = 0; i < 100; ++i)
+            REQUIRE(rows.Get<1>(i) == i);
+    }
+
+    // RemoveAt matches BaseArray in both modes
+    {
+        BigSoaArray<int, std::string> rows;
+        BigArray<int> expected;
+        for (int i = 0; i < 10; ++i)
+        {
+            rows.Push(i, std::to_string(i));
+            expected.Push(i);
+        }
+        rows.RemoveAt(2);
+        expected.RemoveAt(2);
+        rows.SetPreserveOrder(true);
+        expected.SetPreserveOrder(true);
+        rows.RemoveAt(4);
+        expected.RemoveAt(4);
+        rows.RemoveAt(rows.Size() - 1);
+        expected.RemoveAt(expected.Size() - 1);
+        rows.Pop();
+        expected.Pop();
+        REQUIRE(rows.Size() == expected.Size());
+        for (uint32_t i = 0; i < rows.Size(); ++i)
+        {
+            REQUIRE(rows.Get<0>(i) == expected[i]);
+            REQUIRE(rows.Get<1>(i) == std::to_string(expected[i]));
+        }
+
+        BigSoaArray<int, std::string> copy(rows);
+        REQUIRE(copy.Size() == rows.Size());
+        REQUIRE(copy.Get<1>(3) == rows.Get<1>(3));
+        REQUIRE(copy.GetPreserveOrder());
+        BigSoaArray<int, std::string> moved(std::move(copy));
+        REQUIRE(copy.Empty());
+        REQUIRE(moved.Get<1>(3) == rows.Get<1>(3));
+        copy = moved;
+        moved.Clear();
+        REQUIRE(moved.Empty());
+        REQUIRE(copy.Get<0>(0) == 0);
+    }
+
+    // A single allocation per growth, through the rebound allocator
+    {
+        AllocationCounters counters;
+        SoaArray<uint16_t, CountingAllocatorT<uint8_t>, double, uint8_t> rows{CountingAllocatorT<uint8_t>(&counters)};
+        rows.Reserve(100);
+        REQUIRE(counters.m_Allocations == 1);
+        for (int i = 0; i < 100; ++i)
+            rows.Push(i * 0.5, static_cast<uint8_t>(i));
+        REQUIRE(counters.m_Allocations == 1);
+        REQUIRE(ColumnAligned<1>(rows));
+        rows.Push(1.0, static_cast<uint8_t>(1));
+        REQUIRE(counters.m_Allocations == 2);
+        REQUIRE(counters.m_Frees == 1);
+        REQUIRE(rows.Get<0>(99) == 49.5);
+    }
+}
+
+template<typename ChunkPolicy>
+static void CheckSegmented()
+{
+    SegmentedArray<uint32_t, DefaultAllocatorT<uint32_t>, ChunkPolicy> array;
+    BigArray<const uint32_t*> addresses;
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        array.Push(i * 3);
+        addresses.Push(&array.Last());
+    }
+    REQUIRE(array.Size() == 5000);
+    // Elements never move as the array grows.
+    for (uint32_t i = 0; i < 5000; ++i)
+    {
+        REQUIRE(&array[i] == addresses[i]);
+        REQUIRE(array[i] == i * 3);
+    }
+    uint32_t next = 0;
+    for (uint32_t chunk = 0; chunk < array.ChunkCount(); ++chunk)
+    {
+        for (uint32_t value : array.Chunk(chunk))
+            REQUIRE(value == 3 * next++);
+    }
+    REQUIRE(next == 5000);
+    next = 0;
+    for (uint32_t value : array)
+        REQUIRE(value == 3 * next++);
+    REQUIRE(next == 5000);
+
+    for (int i = 0; i < 1000; ++i)
+        array.Pop();
+    REQUIRE(array.Size() == 4000);
+    REQUIRE(std::distance(array.begin(), array.end()) == 4000);
+    const uint32_t capacity = array.Capacity();
+    array.ShrinkToFit();
+    REQUIRE(array.Capacity() <= capacity);
+    REQUIRE(array.Capacity() >= 4000);
+    array.Push(1);
+    REQUIRE(&array[0] == addresses[0]);
+
+    const SegmentedArray<uint32_t, DefaultAllocatorT<uint32_t>, ChunkPolicy> copy(array);
+    REQUIRE(copy.Size() == 4001);
+    REQUIRE(copy[3999] == 3999 * 3);
+    REQUIRE(copy[4000] == 1);
+    array.Clear();
+    REQUIRE(array.Empty());
+    REQUIRE(array.begin() == array.end());
+    REQUIRE(array.Capacity() >= 4000);
+}
+
+TEST_CASE("SegmentedArray")
+{
+    CheckSegmented<FixedChunkPolicy<4>>();
+    CheckSegmented<FixedChunkPolicy<10>>();
+    CheckSegmented<GeometricChunkPolicy<0>>();
+    CheckSegmented<GeometricChunkPolicy<4>>();
+
+    // The geometric policy starts chunk k at (2^k - 1) << SHIFT
+    {
+        uint32_t chunk;
+        uint32_t offset;
+        GeometricChunkPolicy<4>::Locate(15, chunk, offset);
+        REQUIRE((chunk == 0 && offset == 15));
+        GeometricChunkPolicy<4>::Locate(16, chunk, offset);
+        REQUIRE((chunk == 1 && offset == 0));
+        GeometricChunkPolicy<4>::Locate(48, chunk, offset);
+        REQUIRE((chunk == 2 && offset == 0));
+        GeometricChunkPolicy<0>::Locate(0xFFFFFFFE, chunk, offset);
+        REQUIRE((chunk == 31 && offset == 0x7FFFFFFF));
+    }
+
+    // Non-trivial elements are constructed and destroyed in place
+    {
+        const int live = OwningObject::s_Live;
+        {
+            SegmentedArray<OwningObject, DefaultAllocatorT<OwningObject>, FixedChunkPolicy<3>> objects;
+            for (int i = 0; i < 20; ++i)
+                objects.Emplace(i);
+            REQUIRE(OwningObject::s_Live == live + 20);
+            objects.Pop();
+            REQUIRE(OwningObject::s_Live == live + 19);
+            SegmentedArray<OwningObject, DefaultAllocatorT<OwningObject>, FixedChunkPolicy<3>> moved(std::move(objects));
+            REQUIRE(objects.Empty());
+            REQUIRE(*moved[18].m_Value == 18);
+            REQUIRE(OwningObject::s_Live == live + 19);
+        }
+        REQUIRE(OwningObject::s_Live == live);
+    }
+}
+
+TEST_CASE("RingArray")
+{
+    // A FIFO that keeps wrapping around the same buffer
+    {
+        RingArray<uint32_t> ring;
+        std::vector<uint32_t> expected;
+        size_t front = 0;
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            ring.PushBack(i);
+            expected.push_back(i);
+            if (i % 3 == 0)
+            {
+                REQUIRE(ring.First() == expected[front++]);
+                ring.PopFront();
+            }
+        }
+        REQUIRE(ring.Size() == expected.size() - front);
+        REQUIRE((ring.Capacity() & (ring.Capacity() - 1)) == 0);
+        for (uint32_t i = 0; i < ring.Size(); ++i)
+            REQUIRE(ring[i] == expected[front + i]);
+        size_t index = front;
+        for (uint32_t value : ring)
+            REQUIRE(value == expected[index++]);
+        REQUIRE(index == expected.size());
+    }
+
+    // Pushes and pops at both ends
+    {
+        RingArray<int> ring;
+        ring.PushFront(2);
+        ring.PushFront(1);
+        ring.PushBack(3);
+        ring.PushFront(0);
+        REQUIRE(ring.Size() == 4);
+        for (int i = 0; i < 4; ++i)
+            REQUIRE(ring[i] == i);
+        REQUIRE(ring.Last() == 3);
+        ring.PopBack();
+        ring.PopFront();
+        REQUIRE(ring.Size() == 2);
+        REQUIRE(ring.First() == 1);
+        REQUIRE(ring.Last() == 2);
+    }
+
+    // Wrapped contents come out as two segments, and the bulk calls copy across the seam
+    {
+        RingArray<uint32_t> ring;
+        ring.Reserve(16);
+        REQUIRE(ring.Capacity() == 16);
+        uint32_t values[12];
+        for (uint32_t i = 0; i < 12; ++i)
+            values[i] = i;
+        ring.PushBack(values, 12);
+        ring.PopFront(10);
+        ring.PushBack(values, 12);
+        REQUIRE(ring.Capacity() == 16);
+        REQUIRE(ring.Size() == 14);
+        REQUIRE(ring.FirstSegment().Size() == 6);
+        REQUIRE(ring.SecondSegment().Size() == 8);
+        REQUIRE(ring.FirstSegment()[0] == 10);
+        REQUIRE(ring.SecondSegment()[7] == 11);
+
+        uint32_t popped[14];
+        ring.PopFront(popped, 14);
+        REQUIRE(ring.Empty());
+        REQUIRE(popped[0] == 10);
+        REQUIRE(popped[1] == 11);
+        for (uint32_t i = 0; i < 12; ++i)
+            REQUIRE(popped[i + 2] == i);
+
+        // Growing a wrapped ring unwraps it
+        ring.PushBack(values, 12);
+        ring.PopFront(10);
+        ring.PushBack(values, 12);
+        ring.PushBack(values, 12);
+        REQUIRE(ring.Capacity() == 32);
+        REQUIRE(ring.SecondSegment().Empty());
+        REQUIRE(ring[0] == 10);
+        REQUIRE(ring[25] == 11);
+    }
+
+    // A slice of a full ring pushed onto itself, from either segment, with and without growth
+    {
+        for (uint32_t from = 0; from < 2; ++from)
+        {
+            RingArray<std::string> ring;
+            ring.Reserve(8);
+            for (uint32_t i = 0; i < 12; ++i)
+            {
+                if (ring.Size() == 8)
+                    ring.PopFront();
+                ring.PushBack(std::to_string(i));
+            }
+            REQUIRE(ring.Size() == 8);
+            REQUIRE(ring.Capacity() == 8);
+            REQUIRE(!ring.SecondSegment().Empty());
+            // Elements 4 to 11, wrapped after 7
+            const ArraySpan<std::string> segment = from == 0 ? ring.FirstSegment() : ring.SecondSegment();
+            const std::string firstValue = segment[0];
+            ring.PushBack(segment.GetBuffer() + 1, 3);
+            REQUIRE(ring.Size() == 11);
+            REQUIRE(ring.Capacity() == 16);
+            REQUIRE(ring[8] == std::to_string(std::stoi(firstValue) + 1));
+            REQUIRE(ring[10] == std::to_string(std::stoi(firstValue) + 3));
+
+            // Now with room to spare: the copies go to free slots only
+            ring.PopFront(5);
+            ring.PushBack(&ring.First(), 2);
+            REQUIRE(ring.Size() == 8);
+            REQUIRE(ring[6] == ring[0]);
+            REQUIRE(ring[7] == ring[1]);
+        }
+    }
+
+    // Non-trivial elements, copies and moves
+    {
+        const int live = OwningObject::s_Live;
+        {
+            RingArray<OwningObject> objects;
+            for (int i = 0; i < 25; ++i)
+            {
+                objects.EmplaceBack(i);
+                if (i % 5 == 4)
+                    objects.PopFront();
+            }
+            REQUIRE(OwningObject::s_Live == live + 20);
+            objects.EmplaceFront(-1);
+            REQUIRE(*objects.First().m_Value == -1);
+            RingArray<OwningObject> moved(std::move(objects));
+            REQUIRE(objects.Empty());
+            REQUIRE(*moved[20].m_Value == 24);
+            objects = std::move(moved);
+            REQUIRE(*objects[1].m_Value == 5);
+            REQUIRE(OwningObject::s_Live == live + 21);
+        }
+        REQUIRE(OwningObject::s_Live == live);
+
+        RingArray<std::string> strings;
+        strings.PushBack("b");
+        strings.PushFront("a");
+        RingArray<std::string> copy(strings);
+        strings.PopFront();
+        REQUIRE(copy.Size() == 2);
+        REQUIRE(copy[0] == "a");
+        std::string out[2];
+        copy.PopFront(out, 2);
+        REQUIRE(out[1] == "b");
+
+        // Pushing one of its own elements into a full ring, long enough to live on the heap
+        RingArray<std::string> full;
+        for (int i = 0; i < 8; ++i)
+            full.PushBack(std::string(40, static_cast<char>('a' + i)));
+        REQUIRE(full.Size() == full.Capacity());
+        full.PushBack(full.First());
+        REQUIRE(full.Last() == std::string(40, 'a'));
+        for (int i = 0; i < 7; ++i)
+            full.PushBack(std::to_string(i));
+        REQUIRE(full.Size() == full.Capacity());
+        full.PushFront(full.Last());
+        REQUIRE(full.First() == "6");
+        REQUIRE(full[1] == std::string(40, 'a'));
+        REQUIRE(full.Size() == 17);
+    }
+
+    // The inline variant stays off the heap until it is outgrown
+    {
+        AllocationCounters counters;
+        InplaceRingArray<int, 8, CountingAllocatorT<int>> ring{CountingAllocatorT<int>(&counters)};
+        for (int i = 0; i < 100; ++i)
+        {
+            ring.PushBack(i);
+            ring.PushFront(-i);
+            ring.PopBack();
+            if (ring.Size() > 6)
+                ring.PopBack();
+        }
+        REQUIRE(ring.Capacity() == 8);
+        REQUIRE(counters.m_Allocations == 0);
+
+        InplaceRingArray<int, 8, CountingAllocatorT<int>> copy(ring);
+        REQUIRE(copy.Size() == ring.Size());
+        REQUIRE(copy[0] == ring[0]);
+        for (int i = 0; i < 10; ++i)
+            copy.PushBack(i);
+        REQUIRE(copy.Capacity() == 16);
+        REQUIRE(counters.m_Allocations == 1);
+        InplaceRingArray<int, 8, CountingAllocatorT<int>> moved(std::move(copy));
+        REQUIRE(counters.m_Allocations == 1);
+        REQUIRE(moved.Last() == 9);
+        ring.Swap(moved);
+        REQUIRE(ring.Last() == 9);
+        REQUIRE(moved.Capacity() == 8);
+    }
+}
+
+TEST_CASE("SlotMap")
+{
+    // Handles survive the removal of other elements, and stale handles stop matching
+    {
+        SlotMap<uint32_t> map;
+        std::vector<SlotMapHandle> handles;
+        for (uint32_t i = 0; i < 1000; ++i)
+            handles.push_back(map.Insert(i));
+        for (uint32_t i = 0; i < 1000; i += 3)
+            REQUIRE(map.Remove(handles[i]));
+        REQUIRE(map.Size() == 666);
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            const uint32_t* value = map.Find(handles[i]);
+            if (i % 3 == 0)
+            {
+                REQUIRE(value == nullptr);
+                REQUIRE(!map.Contains(handles[i]));
+                REQUIRE(!map.Remove(handles[i]));
+            }
+            else
+            {
+                REQUIRE(value != nullptr);
+                REQUIRE(*value == i);
+                REQUIRE(map[handles[i]] == i);
+            }
+        }
+        REQUIRE(!map.Contains(SlotMapHandle()));
+
+        // Freed slots are reused under a new generation
+        const SlotMapHandle reused = map.Insert(5000);
+        REQUIRE(reused.m_Index == handles[999].m_Index);
+        REQUIRE(reused != handles[999]);
+        REQUIRE(map.Find(handles[999]) == nullptr);
+        REQUIRE(map[reused] == 5000);
+
+        // Dense iteration visits every live element once, and HandleAt names each of them
+        uint64_t sum = 0;
+        for (uint32_t value : map)
+            sum += value;
+        uint64_t expected = 5000;
+        for (uint32_t i = 0; i < 1000; ++i)
+            expected += i % 3 == 0 ? 0 : i;
+        REQUIRE(sum == expected);
+        for (uint32_t i = 0; i < map.Size(); ++i)
+            REQUIRE(&map[map.HandleAt(i)] == &map.GetBuffer()[i]);
+
+        map.Clear();
+        REQUIRE(map.Empty());
+        REQUIRE(!map.Contains(reused));
+        const SlotMapHandle afterClear = map.Insert(7);
+        REQUIRE(map[afterClear] == 7);
+        REQUIRE(map.Size() == 1);
+    }
+
+    // Against a reference map under random inserts and removes
+    {
+        SlotMap<uint64_t> map;
+        std::unordered_map<uint64_t, SlotMapHandle> reference;
+        uint64_t seed = 12345;
+        for (uint64_t i = 0; i < 20000; ++i)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            if ((seed >> 33) % 3 != 0 || reference.empty())
+            {
+                reference[i] = map.Insert(i);
+            }
+            else
+            {
+                auto it = reference.begin();
+                REQUIRE(map.Remove(it->second));
+                reference.erase(it);
+            }
+        }
+        REQUIRE(map.Size() == reference.size());
+        for (const auto& entry : reference)
+            REQUIRE(map[entry.second] == entry.first);
+    }
+
+    // Non-trivial elements, copies and moves
+    {
+        const int live = OwningObject::s_Live;
+        {
+            SlotMap<OwningObject> objects;
+            SlotMapHandle first = objects.Emplace(1);
+            SlotMapHandle second = objects.Emplace(2);
+            objects.Emplace(3);
+            REQUIRE(objects.Remove(first));
+            REQUIRE(OwningObject::s_Live == live + 2);
+            SlotMap<OwningObject> moved(std::move(objects));
+            REQUIRE(objects.Empty());
+            objects.Emplace(4);
+            REQUIRE(*moved[second].m_Value == 2);
+            objects = std::move(moved);
+            REQUIRE(*objects[second].m_Value == 2);
+            REQUIRE(OwningObject::s_Live == live + 2);
+        }
+        REQUIRE(OwningObject::s_Live == live);
+
+        SlotMap<std::string> strings;
+        const SlotMapHandle a = strings.Insert("a");
+        SlotMap<std::string> copy(strings);
+        strings[a] = "b";
+        REQUIRE(copy[a] == "a");
+
+        // Inserting its own elements while the map grows, long enough to live on the heap
+        SlotMap<std::string> grown;
+        const SlotMapHandle original = grown.Insert(std::string(40, 'x'));
+        for (int i = 0; i < 100; ++i)
+        {
+            const SlotMapHandle added = grown.Insert(*grown.Find(original));
+            REQUIRE(grown[added] == std::string(40, 'x'));
+        }
+        const SlotMapHandle moved = grown.Insert(std::move(grown[original]));
+        REQUIRE(grown[moved] == std::string(40, 'x'));
+        REQUIRE(grown.Size() == 102);
+    }
+}
+
+TEST_CASE("SparseSet")
+{
+    // Ids spread over a large range only allocate the pages they fall in
+    {
+        AllocationCounters counters;
+        SparseSet<uint64_t, CountingAllocatorT<uint64_t>, 10> set{CountingAllocatorT<uint64_t>(&counters)};
+        std::unordered_map<uint32_t, uint64_t> reference;
+        uint64_t seed = 99;
+        for (uint32_t i = 0; i < 5000; ++i)
+        {
+            seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+            const uint32_t id = static_cast<uint32_t>(seed >> 40) % 64 + ((seed >> 20) % 50) * 1000000;
+            REQUIRE(set.Insert(id, i) == reference.emplace(id, i).second);
+        }
+        REQUIRE(set.Size() == reference.size());
+        REQUIRE(set.PageCount() <= 50 * 2);
+        for (const auto& entry : reference)
+        {
+            REQUIRE(set.Contains(entry.first));
+            REQUIRE(*set.Find(entry.first) == entry.second);
+        }
+        REQUIRE(!set.Contains(999999999));
+
+        // Removing half keeps the rest reachable through the moved dense entries
+        uint32_t removed = 0;
+        for (auto it = reference.begin(); it != reference.end();)
+        {
+            if (it->first % 2 == 0)
+            {
+                REQUIRE(set.Remove(it->first));
+                REQUIRE(!set.Remove(it->first));
+                it = reference.erase(it);
+                ++removed;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        REQUIRE(removed > 0);
+        REQUIRE(set.Size() == reference.size());
+        for (uint32_t i = 0; i < set.Size(); ++i)
+            REQUIRE(reference.at(set.Ids()[i]) == set.Values()[i]);
+
+        const int pagesBeforeClear = counters.m_Allocations;
+        set.Clear();
+        REQUIRE(set.Empty());
+        REQUIRE(!set.Contains(reference.begin()->first));
+        set[reference.begin()->first] = 7;
+        REQUIRE(*set.Find(reference.begin()->first) == 7);
+        REQUIRE(counters.m_Allocations == pagesBeforeClear);
+    }
+
+    // Intersection visits each shared id once, whichever side is smaller
+    {
+        SparseSet<int> multiples2;
+        SparseSet<std::string> multiples3;
+        for (uint32_t id = 0; id < 100000; id += 2)
+            multiples2.Insert(id, static_cast<int>(id));
+        for (uint32_t id = 0; id < 30000; id += 3)
+            multiples3.Insert(id, std::to_string(id));
+        uint32_t count = 0;
+        multiples2.Intersect(multiples3, [&](uint32_t id, int& value, const std::string& text)
+        {
+            REQUIRE(id % 6 == 0);
+            REQUIRE(static_cast<uint32_t>(value) == id);
+            REQUIRE(text == std::to_string(id));
+            ++count;
+        });
+        REQUIRE(count == 5000);
+        count = 0;
+        multiples3.Intersect(multiples2, [&](uint32_t id, std::string& text, const int& value)
+        {
+            REQUIRE(text == std::to_string(value));
+            REQUIRE(id % 6 == 0);
+            ++count;
+        });
+        REQUIRE(count == 5000);
+    }
+
+    // Non-trivial values, copies and moves
+    {
+        const int live = OwningObject::s_Live;
+        {
+            SparseSet<OwningObject> objects;
+            objects.Emplace(5, 5);
+            objects.Emplace(50000, 6);
+            REQUIRE(!objects.Emplace(5, 7));
+            REQUIRE(OwningObject::s_Live == live + 2);
+            SparseSet<OwningObject> moved(std::move(objects));
+            REQUIRE(objects.Empty());
+            REQUIRE(!objects.Contains(5));
+            REQUIRE(*moved.Find(50000)->m_Value == 6);
+            objects = std::move(moved);
+            REQUIRE(objects.Remove(5));
+            REQUIRE(*objects.Find(50000)->m_Value == 6);
+            REQUIRE(OwningObject::s_Live == live + 1);
+        }
+        REQUIRE(OwningObject::s_Live == live);
+
+        SparseSet<std::string> strings;
+        strings.Insert(70000, "a");
+        SparseSet<std::string> copy(strings);
+        strings[70000] = "b";
+        strings.Remove(70000);
+        REQUIRE(*copy.Find(70000) == "a");
+        REQUIRE(copy.PageCount() == 1);
+    }
+}
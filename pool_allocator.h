@@ -0,0 +1,266 @@
+#pragma once
+#include "array.h"
+
+#include <mutex>
+#include <stddef.h>
+
+// Size-class pool for small arrays. Blocks come in power-of-two payload sizes from
+// MIN_BLOCK_SIZE to MAX_BLOCK_SIZE bytes and are recycled through per-thread free lists,
+// so the common allocate/free pair touches no lock. A thread whose list for a class grows
+// past 2 * BATCH_SIZE hands a batch back to the global pool, and a thread that runs dry
+// takes a whole batch at once. Larger requests go straight to malloc.
+// Memory held by the pool is reused but never returned to the system.
+class SizeClassPool
+{
+public:
+    enum : size_t
+    {
+        MIN_BLOCK_SIZE = 16,
+        MAX_BLOCK_SIZE = 64 * 1024,
+        MAX_ALIGNMENT = 16,
+    };
+    enum : uint32_t
+    {
+        NUM_CLASSES = 13,
+        BATCH_SIZE = 32,
+        LARGE_CLASS = 0xFFFFFFFF,
+    };
+
+    static void* Allocate(size_t bytes)
+    {
+        uint32_t sizeClass = SizeClassFor(bytes);
+        BlockHeader* header;
+        if (sizeClass == LARGE_CLASS)
+        {
+            header = static_cast<BlockHeader*>(malloc(sizeof(BlockHeader) + bytes));
+            ASSERT(header != nullptr);
+        }
+        else if (ThreadCache* cache = GetThreadCache())
+        {
+            header = reinterpret_cast<BlockHeader*>(cache->Pop(sizeClass));
+        }
+        else
+        {
+            header = reinterpret_cast<BlockHeader*>(GetGlobalPool().TakeOne(sizeClass));
+        }
+        header->m_SizeClass = sizeClass;
+        return header + 1;
+    }
+
+    static void Free(void* data)
+    {
+        if (data == nullptr)
+            return;
+        BlockHeader* header = static_cast<BlockHeader*>(data) - 1;
+        FreeNode* node = reinterpret_cast<FreeNode*>(header);
+        if (header->m_SizeClass == LARGE_CLASS)
+        {
+            free(header);
+        }
+        else if (ThreadCache* cache = GetThreadCache())
+        {
+            cache->Push(header->m_SizeClass, node);
+        }
+        else
+        {
+            node->m_Next = nullptr;
+            GetGlobalPool().ReturnBatch(header->m_SizeClass, node, 1);
+        }
+    }
+
+    // Blocks can grow in place up to the payload size of their class.
+    static bool TryExpand(void* data, size_t bytes)
+    {
+        if (data == nullptr)
+            return false;
+        const BlockHeader* header = static_cast<const BlockHeader*>(data) - 1;
+        return header->m_SizeClass != LARGE_CLASS && bytes <= ClassSize(header->m_SizeClass);
+    }
+
+    static size_t ClassSize(uint32_t sizeClass) { return MIN_BLOCK_SIZE << sizeClass; }
+
+    static uint32_t SizeClassFor(size_t bytes)
+    {
+        if (bytes > MAX_BLOCK_SIZE)
+            return LARGE_CLASS;
+        uint32_t sizeClass = 0;
+        while (ClassSize(sizeClass) < bytes)
+            ++sizeClass;
+        return sizeClass;
+    }
+
+private:
+    struct BlockHeader
+    {
+        uint32_t m_SizeClass;
+        uint32_t m_Padding[3];
+    };
+    static_assert(sizeof(BlockHeader) == MAX_ALIGNMENT, "Block payloads must stay 16 byte aligned");
+
+    // Free blocks are linked through their own memory. The first node of a batch parked
+    // in the global pool also records the batch length and links to the next batch.
+    struct FreeNode
+    {
+        FreeNode* m_Next;
+        FreeNode* m_NextBatch;
+        uint32_t m_BatchCount;
+    };
+
+    struct GlobalPool
+    {
+        std::mutex m_Mutex;
+        FreeNode* m_Batches[NUM_CLASSES];
+        void* m_Slabs;
+
+        GlobalPool() : m_Slabs(nullptr)
+        {
+            for (uint32_t i = 0; i < NUM_CLASSES; ++i)
+                m_Batches[i] = nullptr;
+        }
+
+        // Returns a chain of at most BATCH_SIZE free blocks.
+        FreeNode* TakeBatch(uint32_t sizeClass)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            FreeNode* batch = m_Batches[sizeClass];
+            if (batch != nullptr)
+            {
+                m_Batches[sizeClass] = batch->m_NextBatch;
+                return batch;
+            }
+            return CarveSlab(sizeClass);
+        }
+
+        // Used once the calling thread's cache is gone, e.g. by arrays destroyed after
+        // thread_local objects during process exit.
+        FreeNode* TakeOne(uint32_t sizeClass)
+        {
+            FreeNode* batch = TakeBatch(sizeClass);
+            if (batch->m_Next != nullptr)
+                ReturnBatch(sizeClass, batch->m_Next, batch->m_BatchCount - 1);
+            return batch;
+        }
+
+        void ReturnBatch(uint32_t sizeClass, FreeNode* batch, uint32_t count)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            batch->m_BatchCount = count;
+            batch->m_NextBatch = m_Batches[sizeClass];
+            m_Batches[sizeClass] = batch;
+        }
+
+        FreeNode* CarveSlab(uint32_t sizeClass)
+        {
+            const size_t blockSize = sizeof(BlockHeader) + ClassSize(sizeClass);
+            // Slabs are chained through their first 16 bytes so they stay reachable.
+            char* slab = static_cast<char*>(malloc(MAX_ALIGNMENT + blockSize * BATCH_SIZE));
+            ASSERT(slab != nullptr);
+            *reinterpret_cast<void**>(slab) = m_Slabs;
+            m_Slabs = slab;
+            char* blocks = slab + MAX_ALIGNMENT;
+            for (uint32_t i = 0; i < BATCH_SIZE; ++i)
+            {
+                FreeNode* node = reinterpret_cast<FreeNode*>(blocks + i * blockSize);
+                node->m_Next = i + 1 < BATCH_SIZE ? reinterpret_cast<FreeNode*>(blocks + (i + 1) * blockSize) : nullptr;
+            }
+            FreeNode* batch = reinterpret_cast<FreeNode*>(blocks);
+            batch->m_BatchCount = BATCH_SIZE;
+            return batch;
+        }
+    };
+
+    struct ThreadCache
+    {
+        FreeNode* m_Heads[NUM_CLASSES];
+        uint32_t m_Counts[NUM_CLASSES];
+
+        ThreadCache()
+        {
+            for (uint32_t i = 0; i < NUM_CLASSES; ++i)
+            {
+                m_Heads[i] = nullptr;
+                m_Counts[i] = 0;
+            }
+        }
+
+        ~ThreadCache()
+        {
+            IsThreadCacheDestroyed() = true;
+            for (uint32_t i = 0; i < NUM_CLASSES; ++i)
+            {
+                while (m_Counts[i] > 0)
+                {
+                    uint32_t count = m_Counts[i] < BATCH_SIZE ? m_Counts[i] : BATCH_SIZE;
+                    GetGlobalPool().ReturnBatch(i, DetachBatch(i, count), count);
+                }
+            }
+        }
+
+        void* Pop(uint32_t sizeClass)
+        {
+            if (m_Heads[sizeClass] == nullptr)
+            {
+                m_Heads[sizeClass] = GetGlobalPool().TakeBatch(sizeClass);
+                m_Counts[sizeClass] = m_Heads[sizeClass]->m_BatchCount;
+            }
+            FreeNode* node = m_Heads[sizeClass];
+            m_Heads[sizeClass] = node->m_Next;
+            --m_Counts[sizeClass];
+            return node;
+        }
+
+        void Push(uint32_t sizeClass, FreeNode* node)
+        {
+            node->m_Next = m_Heads[sizeClass];
+            m_Heads[sizeClass] = node;
+            if (++m_Counts[sizeClass] >= 2 * BATCH_SIZE)
+                GetGlobalPool().ReturnBatch(sizeClass, DetachBatch(sizeClass, BATCH_SIZE), BATCH_SIZE);
+        }
+
+        FreeNode* DetachBatch(uint32_t sizeClass, uint32_t count)
+        {
+            FreeNode* batch = m_Heads[sizeClass];
+            FreeNode* last = batch;
+            for (uint32_t i = 1; i < count; ++i)
+                last = last->m_Next;
+            m_Heads[sizeClass] = last->m_Next;
+            last->m_Next = nullptr;
+            m_Counts[sizeClass] -= count;
+            return batch;
+        }
+    };
+
+    // Never destroyed, so thread caches flushing at exit always find it.
+    static GlobalPool& GetGlobalPool()
+    {
+        static GlobalPool* pool = new GlobalPool();
+        return *pool;
+    }
+
+    // Trivially destructible, so it can still be read after the cache is destroyed.
+    static bool& IsThreadCacheDestroyed()
+    {
+        static thread_local bool destroyed = false;
+        return destroyed;
+    }
+
+    static ThreadCache* GetThreadCache()
+    {
+        if (IsThreadCacheDestroyed())
+            return nullptr;
+        static thread_local ThreadCache cache;
+        return &cache;
+    }
+};
+
+// Stateless allocator serving BaseArray buffers from the SizeClassPool. Usable as the
+// Allocator argument of Array, BigArray and InplaceArray.
+template<typename T>
+struct PoolAllocatorT
+{
+    static_assert(alignof(T) <= SizeClassPool::MAX_ALIGNMENT, "PoolAllocatorT only supports alignments up to 16 bytes");
+
+    static T* Allocate(uint32_t numItems) { return static_cast<T*>(SizeClassPool::Allocate(sizeof(T) * numItems)); }
+    static void Free(T* data) { SizeClassPool::Free(data); }
+    static bool TryExpand(T* data, uint32_t numItems) { return SizeClassPool::TryExpand(data, sizeof(T) * numItems); }
+};
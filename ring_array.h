@@ -0,0 +1,427 @@
+#pragma once
+#include "array.h"
+
+#include <algorithm>
+
+// A double ended queue in one power-of-two sized buffer. The elements start at m_Head and
+// wrap around the end of the buffer, so pushing and popping at either end is O(1) and
+// indices are mapped with a mask instead of a division. Use it instead of RemoveAt(0) on
+// an ordered array, which shifts every remaining element.
+//
+// The elements occupy at most two contiguous runs, FirstSegment and SecondSegment, which
+// is also how the bulk PushBack and PopFront copy them. That is also why the buffer isn't
+// a BaseArray's: everything there assumes the elements run from the start of the buffer.
+// The element helpers (ObjectRange) and allocator storage are shared with array.h.
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, typename CheckPolicy = DefaultCheckPolicy>
+class RingArray : private AllocatorStorage<Allocator>
+{
+    typedef AllocatorStorage<Allocator> AllocatorBase;
+public:
+    template<typename T>
+    class IteratorT
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        // position counts from the start of the buffer without wrapping; the mask wraps it.
+        IteratorT(T* data, uint32_t mask, uint32_t position)
+            : m_Data(data)
+            , m_Mask(mask)
+            , m_Position(position)
+        {
+        }
+
+        T& operator*() const { return m_Data[m_Position & m_Mask]; }
+        T* operator->() const { return &m_Data[m_Position & m_Mask]; }
+        IteratorT& operator++()
+        {
+            ++m_Position;
+            return *this;
+        }
+        bool operator==(const IteratorT& other) const { return m_Position == other.m_Position; }
+        bool operator!=(const IteratorT& other) const { return m_Position != other.m_Position; }
+
+    private:
+        T* m_Data;
+        uint32_t m_Mask;
+        uint32_t m_Position;
+    };
+
+    typedef IteratorT<ObjectType> Iterator;
+    typedef IteratorT<const ObjectType> ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    RingArray()
+        : RingArray(Allocator())
+    {
+    }
+    explicit RingArray(const Allocator& allocator)
+        : AllocatorBase(allocator)
+        , m_Data(nullptr)
+        , m_Head(0)
+        , m_Size(0)
+        , m_Capacity(0)
+        , m_OwnsData(true)
+    {
+    }
+    RingArray(const RingArray& other)
+        : RingArray(other.GetAllocator())
+    {
+        CopyFrom(other);
+    }
+    RingArray(RingArray&& other)
+        : RingArray(other.GetAllocator())
+    {
+        MoveFrom(other);
+    }
+
+    ~RingArray()
+    {
+        Clear();
+        if (m_OwnsData)
+            GetAllocator().Free(m_Data);
+    }
+
+    RingArray& operator=(const RingArray& other)
+    {
+        if (this != &other)
+        {
+            Clear();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    RingArray& operator=(RingArray&& other)
+    {
+        if (this != &other)
+        {
+            Clear();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    // Exchanges contents and allocators. Borrowed buffers stay with the array that lent them.
+    void Swap(RingArray& other)
+    {
+        if (m_OwnsData && other.m_OwnsData)
+        {
+            std::swap(m_Data, other.m_Data);
+            std::swap(m_Head, other.m_Head);
+            std::swap(m_Size, other.m_Size);
+            std::swap(m_Capacity, other.m_Capacity);
+            std::swap(GetAllocator(), other.GetAllocator());
+        }
+        else
+        {
+            RingArray temp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+    }
+
+    Allocator& GetAllocator() { return AllocatorBase::GetAllocator(); }
+    const Allocator& GetAllocator() const { return AllocatorBase::GetAllocator(); }
+
+    Iterator begin() { return Iterator(m_Data, Mask(), m_Head); }
+    Iterator end() { return Iterator(m_Data, Mask(), m_Head + m_Size); }
+    ConstIterator begin() const { return ConstIterator(m_Data, Mask(), m_Head); }
+    ConstIterator end() const { return ConstIterator(m_Data, Mask(), m_Head + m_Size); }
+
+    uint32_t Size() const { return m_Size; }
+    uint32_t Capacity() const { return m_Capacity; }
+    bool Empty() const { return m_Size == 0; }
+
+    // The elements from the front up to the end of the buffer, then the ones that wrapped
+    // around to its start. SecondSegment is empty unless the elements wrap.
+    ArraySpan<ObjectType> FirstSegment() { return ArraySpan<ObjectType>(m_Data + m_Head, FirstSegmentSize()); }
+    ArraySpan<ObjectType> SecondSegment() { return ArraySpan<ObjectType>(m_Data, m_Size - FirstSegmentSize()); }
+    ArraySpan<const ObjectType> FirstSegment() const { return ArraySpan<const ObjectType>(m_Data + m_Head, FirstSegmentSize()); }
+    ArraySpan<const ObjectType> SecondSegment() const { return ArraySpan<const ObjectType>(m_Data, m_Size - FirstSegmentSize()); }
+
+    // Index 0 is the front.
+    ObjectType& operator[](uint32_t index)
+    {
+        CheckPolicy::Check(index < m_Size);
+        return m_Data[(m_Head + index) & Mask()];
+    }
+
+    const ObjectType& operator[](uint32_t index) const
+    {
+        CheckPolicy::Check(index < m_Size);
+        return m_Data[(m_Head + index) & Mask()];
+    }
+
+    ObjectType& First()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        return m_Data[m_Head];
+    }
+
+    ObjectType& Last()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        return m_Data[(m_Head + m_Size - 1) & Mask()];
+    }
+
+    // Rounds capacity up to a power of two. Growing moves the elements to the start of the
+    // new buffer.
+    void Reserve(uint32_t capacity)
+    {
+        if (capacity > m_Capacity)
+            Reallocate(RoundUpCapacity(capacity));
+    }
+
+    void PushBack(const ObjectType& object) { EmplaceBack(object); }
+    void PushBack(ObjectType&& object) { EmplaceBack(std::move(object)); }
+    void PushFront(const ObjectType& object) { EmplaceFront(object); }
+    void PushFront(ObjectType&& object) { EmplaceFront(std::move(object)); }
+
+    template<typename... Args>
+    ObjectType& EmplaceBack(Args&&... args)
+    {
+        if (m_Size == m_Capacity)
+            return GrowAndEmplace(false, std::forward<Args>(args)...);
+        ObjectType* object = new (&m_Data[(m_Head + m_Size) & Mask()]) ObjectType(std::forward<Args>(args)...);
+        ++m_Size;
+        return *object;
+    }
+
+    template<typename... Args>
+    ObjectType& EmplaceFront(Args&&... args)
+    {
+        if (m_Size == m_Capacity)
+            return GrowAndEmplace(true, std::forward<Args>(args)...);
+        const uint32_t head = (m_Head - 1) & Mask();
+        ObjectType* object = new (&m_Data[head]) ObjectType(std::forward<Args>(args)...);
+        m_Head = head;
+        ++m_Size;
+        return *object;
+    }
+
+    // Copies the count objects at values to the back, at most two contiguous copies.
+    // values may point into this ring.
+    void PushBack(const ObjectType* values, uint32_t count)
+    {
+        if (count == 0)
+            return;
+        if (static_cast<uint64_t>(m_Size) + count > m_Capacity)
+        {
+            Reallocate(GrownCapacity(static_cast<uint64_t>(m_Size) + count), values, count);
+            m_Size += count;
+            return;
+        }
+        // Without growth the copies land in free slots, so a source inside the ring is
+        // neither moved nor overwritten.
+        const uint32_t tail = (m_Head + m_Size) & Mask();
+        const uint32_t first = std::min(count, m_Capacity - tail);
+        ObjectRange<ObjectType>::Copy(m_Data + tail, values, first);
+        ObjectRange<ObjectType>::Copy(m_Data, values + first, count - first);
+        m_Size += count;
+    }
+
+    void PopFront()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        m_Data[m_Head].~ObjectType();
+        m_Head = (m_Head + 1) & Mask();
+        --m_Size;
+    }
+
+    void PopBack()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        --m_Size;
+        m_Data[(m_Head + m_Size) & Mask()].~ObjectType();
+    }
+
+    // Removes the first count elements.
+    void PopFront(uint32_t count)
+    {
+        CheckPolicy::Check(count <= m_Size);
+        const uint32_t first = std::min(count, m_Capacity - m_Head);
+        ObjectRange<ObjectType>::Destroy(m_Data + m_Head, first);
+        ObjectRange<ObjectType>::Destroy(m_Data, count - first);
+        m_Head = (m_Head + count) & Mask();
+        m_Size -= count;
+    }
+
+    // Moves the first count elements into the count objects at dest, then removes them.
+    void PopFront(ObjectType* dest, uint32_t count)
+    {
+        CheckPolicy::Check(count <= m_Size);
+        const uint32_t first = std::min(count, m_Capacity - m_Head);
+        ObjectRange<ObjectType>::MoveAssign(dest, m_Data + m_Head, first);
+        ObjectRange<ObjectType>::MoveAssign(dest + first, m_Data, count - first);
+        PopFront(count);
+    }
+
+    void Clear()
+    {
+        PopFront(m_Size);
+        m_Head = 0;
+    }
+
+protected:
+    // For InplaceRingArray: starts out on a buffer it doesn't own.
+    RingArray(ObjectType* data, uint32_t capacity, const Allocator& allocator)
+        : RingArray(allocator)
+    {
+        ASSERT((capacity & (capacity - 1)) == 0);
+        m_Data = data;
+        m_Capacity = capacity;
+        m_OwnsData = false;
+    }
+
+private:
+    enum : uint32_t { MIN_CAPACITY = 8 };
+
+    uint32_t Mask() const { return m_Capacity - 1; }
+    uint32_t FirstSegmentSize() const { return std::min(m_Size, m_Capacity - m_Head); }
+
+    static uint32_t RoundUpCapacity(uint64_t required)
+    {
+        ASSERT(required <= (1u << 31));
+        uint32_t capacity = MIN_CAPACITY;
+        while (capacity < required)
+            capacity *= 2;
+        return capacity;
+    }
+
+    // At least double, so a run of pushes reallocates O(log n) times.
+    uint32_t GrownCapacity(uint64_t required) const
+    {
+        return RoundUpCapacity(std::max<uint64_t>(required, static_cast<uint64_t>(m_Capacity) * 2));
+    }
+
+    // Moves the elements to the start of a new buffer of capacity elements. The
+    // appendedCount objects at appended are copied in after them, before the old buffer
+    // is freed, so they may come from it; the caller accounts for them in m_Size.
+    void Reallocate(uint32_t capacity, const ObjectType* appended = nullptr, uint32_t appendedCount = 0)
+    {
+        ObjectType* newData = GetAllocator().Allocate(capacity);
+        ASSERT(newData != nullptr);
+        ObjectRange<ObjectType>::Copy(newData + m_Size, appended, appendedCount);
+        MoveToBuffer(newData, capacity);
+    }
+
+    // Grows a full ring and constructs the new back or front element in the new buffer
+    // before the old one is freed, so args may refer to elements of this ring.
+    template<typename... Args>
+    ObjectType& GrowAndEmplace(bool front, Args&&... args)
+    {
+        const uint32_t capacity = GrownCapacity(static_cast<uint64_t>(m_Size) + 1);
+        ObjectType* newData = GetAllocator().Allocate(capacity);
+        ASSERT(newData != nullptr);
+        // A new front element wraps around to the last slot.
+        const uint32_t slot = front ? capacity - 1 : m_Size;
+        ObjectType* object = new (&newData[slot]) ObjectType(std::forward<Args>(args)...);
+        MoveToBuffer(newData, capacity);
+        if (front)
+            m_Head = slot;
+        ++m_Size;
+        return *object;
+    }
+
+    // Relocates the elements to the start of newData and frees the old buffer.
+    void MoveToBuffer(ObjectType* newData, uint32_t capacity)
+    {
+        const uint32_t first = FirstSegmentSize();
+        ObjectRange<ObjectType>::Relocate(newData, m_Data + m_Head, first);
+        ObjectRange<ObjectType>::Relocate(newData + first, m_Data, m_Size - first);
+        if (m_OwnsData)
+            GetAllocator().Free(m_Data);
+        m_Data = newData;
+        m_Head = 0;
+        m_Capacity = capacity;
+        m_OwnsData = true;
+    }
+
+    void CopyFrom(const RingArray& other)
+    {
+        Reserve(other.m_Size);
+        const ArraySpan<const ObjectType> first = other.FirstSegment();
+        const ArraySpan<const ObjectType> second = other.SecondSegment();
+        PushBack(first.GetBuffer(), static_cast<uint32_t>(first.Size()));
+        PushBack(second.GetBuffer(), static_cast<uint32_t>(second.Size()));
+    }
+
+    // Takes over other's buffer when it owns one, otherwise relocates its elements. Must be
+    // empty.
+    void MoveFrom(RingArray& other)
+    {
+        if (other.m_OwnsData)
+        {
+            if (m_OwnsData)
+                GetAllocator().Free(m_Data);
+            GetAllocator() = other.GetAllocator();
+            m_Data = other.m_Data;
+            m_Head = other.m_Head;
+            m_Size = other.m_Size;
+            m_Capacity = other.m_Capacity;
+            m_OwnsData = true;
+            other.m_Data = nullptr;
+            other.m_Head = 0;
+            other.m_Size = 0;
+            other.m_Capacity = 0;
+        }
+        else
+        {
+            Reserve(other.m_Size);
+            m_Head = 0;
+            const uint32_t first = other.FirstSegmentSize();
+            ObjectRange<ObjectType>::Relocate(m_Data, other.m_Data + other.m_Head, first);
+            ObjectRange<ObjectType>::Relocate(m_Data + first, other.m_Data, other.m_Size - first);
+            m_Size = other.m_Size;
+            other.m_Head = 0;
+            other.m_Size = 0;
+        }
+    }
+
+    ObjectType* m_Data;
+    uint32_t m_Head;
+    uint32_t m_Size;
+    uint32_t m_Capacity;
+    bool m_OwnsData;
+};
+
+// A RingArray holding its first FIXED_SIZE elements inside the object, which must be a
+// power of two. It moves to the heap only when it outgrows them.
+template<typename ObjectType, uint32_t FIXED_SIZE, typename Allocator = DefaultAllocatorT<ObjectType>, typename CheckPolicy = DefaultCheckPolicy>
+class InplaceRingArray : public RingArray<ObjectType, Allocator, CheckPolicy>
+{
+    typedef RingArray<ObjectType, Allocator, CheckPolicy> super;
+    static_assert(FIXED_SIZE > 0 && (FIXED_SIZE & (FIXED_SIZE - 1)) == 0, "FIXED_SIZE must be a power of two");
+public:
+    InplaceRingArray() : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), FIXED_SIZE, Allocator()) {}
+    explicit InplaceRingArray(const Allocator& allocator) : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), FIXED_SIZE, allocator) {}
+    InplaceRingArray(const InplaceRingArray& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), FIXED_SIZE, other.GetAllocator())
+    {
+        super::operator=(other);
+    }
+    InplaceRingArray(InplaceRingArray&& other)
+        : super(reinterpret_cast<ObjectType*>(&m_FixedBuffer), FIXED_SIZE, other.GetAllocator())
+    {
+        super::operator=(std::move(other));
+    }
+    InplaceRingArray& operator=(const InplaceRingArray& other)
+    {
+        super::operator=(other);
+        return *this;
+    }
+    InplaceRingArray& operator=(InplaceRingArray&& other)
+    {
+        super::operator=(std::move(other));
+        return *this;
+    }
+
+private:
+    typename std::aligned_storage<sizeof(ObjectType)*FIXED_SIZE, alignof(ObjectType)>::type m_FixedBuffer;
+};
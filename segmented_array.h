@@ -0,0 +1,310 @@
+#pragma once
+#include "array.h"
+
+// Chunk policies map an element index to a chunk and an offset within it. Chunk sizes
+// only depend on the chunk number, so the table of chunk pointers is all the state needed.
+
+// Chunks of 2^SHIFT elements each.
+template<uint32_t SHIFT = 10>
+struct FixedChunkPolicy
+{
+    static_assert(SHIFT < 32, "Chunks must hold fewer than 2^32 elements");
+    static uint32_t ChunkSize(uint32_t /*chunk*/) { return 1u << SHIFT; }
+    static void Locate(uint32_t index, uint32_t& chunk, uint32_t& offset)
+    {
+        chunk = index >> SHIFT;
+        offset = index & ((1u << SHIFT) - 1);
+    }
+};
+
+// Chunk k holds 2^(SHIFT + k) elements, so each chunk doubles the capacity and a handful
+// of chunks cover a very large array. Chunk k starts at index (2^k - 1) * 2^SHIFT.
+template<uint32_t SHIFT = 4>
+struct GeometricChunkPolicy
+{
+    static_assert(SHIFT < 32, "Chunks must hold fewer than 2^32 elements");
+    static uint32_t ChunkSize(uint32_t chunk) { return 1u << (SHIFT + chunk); }
+    static void Locate(uint32_t index, uint32_t& chunk, uint32_t& offset)
+    {
+        const uint64_t biased = (static_cast<uint64_t>(index) >> SHIFT) + 1;
+        chunk = 63 - __builtin_clzll(biased);
+        offset = index - static_cast<uint32_t>(((1ull << chunk) - 1) << SHIFT);
+    }
+};
+
+// An array that grows by adding chunks instead of reallocating, so elements never move
+// and pointers to them stay valid until they are popped. Indexing goes through a table of
+// chunk pointers. Loops that should vectorize can walk the chunks as contiguous spans
+// with ChunkCount and Chunk.
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, typename ChunkPolicy = FixedChunkPolicy<>, typename CheckPolicy = DefaultCheckPolicy>
+class SegmentedArray : private AllocatorStorage<Allocator>
+{
+    typedef AllocatorStorage<Allocator> AllocatorBase;
+    typedef AllocatorRebind<Allocator, ObjectType*> TableRebind;
+public:
+    template<typename T>
+    class IteratorT
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef T& reference;
+
+        IteratorT(ObjectType* const* chunks, uint32_t chunk, T* current, T* chunkEnd, T* end)
+            : m_Chunks(chunks)
+            , m_Chunk(chunk)
+            , m_Current(current)
+            , m_ChunkEnd(chunkEnd)
+            , m_End(end)
+        {
+        }
+
+        T& operator*() const { return *m_Current; }
+        T* operator->() const { return m_Current; }
+        IteratorT& operator++()
+        {
+            if (++m_Current == m_ChunkEnd && m_Current != m_End)
+            {
+                ++m_Chunk;
+                m_Current = m_Chunks[m_Chunk];
+                m_ChunkEnd = m_Current + ChunkPolicy::ChunkSize(m_Chunk);
+            }
+            return *this;
+        }
+        bool operator==(const IteratorT& other) const { return m_Current == other.m_Current; }
+        bool operator!=(const IteratorT& other) const { return m_Current != other.m_Current; }
+
+    private:
+        ObjectType* const* m_Chunks;
+        uint32_t m_Chunk;
+        T* m_Current;
+        T* m_ChunkEnd;
+        T* m_End;
+    };
+
+    typedef IteratorT<ObjectType> Iterator;
+    typedef IteratorT<const ObjectType> ConstIterator;
+    typedef Iterator iterator;
+    typedef ConstIterator const_iterator;
+
+    SegmentedArray()
+        : SegmentedArray(Allocator())
+    {
+    }
+    explicit SegmentedArray(const Allocator& allocator)
+        : AllocatorBase(allocator)
+        , m_Chunks(TableRebind::Convert(allocator))
+        , m_Size(0)
+        , m_Capacity(0)
+    {
+    }
+    SegmentedArray(const SegmentedArray& other)
+        : SegmentedArray(other.GetAllocator())
+    {
+        Reserve(other.m_Size);
+        for (uint32_t chunk = 0; chunk < other.ChunkCount(); ++chunk)
+        {
+            ArraySpan<const ObjectType> source = other.Chunk(chunk);
+            for (size_t i = 0; i < source.Size(); ++i)
+                new (&m_Chunks[chunk][i]) ObjectType(source[i]);
+        }
+        m_Size = other.m_Size;
+    }
+    SegmentedArray(SegmentedArray&& other)
+        : AllocatorBase(other.GetAllocator())
+        , m_Chunks(std::move(other.m_Chunks))
+        , m_Size(other.m_Size)
+        , m_Capacity(other.m_Capacity)
+    {
+        other.m_Size = 0;
+        other.m_Capacity = 0;
+    }
+
+    ~SegmentedArray()
+    {
+        Clear();
+        FreeChunks(0);
+    }
+
+    SegmentedArray& operator=(const SegmentedArray& other)
+    {
+        if (this != &other)
+        {
+            SegmentedArray copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SegmentedArray& operator=(SegmentedArray&& other)
+    {
+        if (this != &other)
+        {
+            SegmentedArray moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(SegmentedArray& other)
+    {
+        std::swap(GetAllocator(), other.GetAllocator());
+        m_Chunks.Swap(other.m_Chunks);
+        std::swap(m_Size, other.m_Size);
+        std::swap(m_Capacity, other.m_Capacity);
+    }
+
+    Allocator& GetAllocator() { return AllocatorBase::GetAllocator(); }
+    const Allocator& GetAllocator() const { return AllocatorBase::GetAllocator(); }
+
+    Iterator begin() { return MakeIterator<ObjectType>(); }
+    Iterator end() { return Iterator(nullptr, 0, EndPointer(), nullptr, EndPointer()); }
+    ConstIterator begin() const { return MakeIterator<const ObjectType>(); }
+    ConstIterator end() const { return ConstIterator(nullptr, 0, EndPointer(), nullptr, EndPointer()); }
+
+    uint32_t Size() const { return m_Size; }
+    uint32_t Capacity() const { return m_Capacity; }
+    bool Empty() const { return m_Size == 0; }
+
+    // Chunks holding elements, the last one possibly partly filled.
+    uint32_t ChunkCount() const
+    {
+        if (m_Size == 0)
+            return 0;
+        uint32_t chunk;
+        uint32_t offset;
+        ChunkPolicy::Locate(m_Size - 1, chunk, offset);
+        return chunk + 1;
+    }
+
+    // The elements of chunk number chunk, which must be below ChunkCount().
+    ArraySpan<ObjectType> Chunk(uint32_t chunk) { return ArraySpan<ObjectType>(m_Chunks[chunk], UsedInChunk(chunk)); }
+    ArraySpan<const ObjectType> Chunk(uint32_t chunk) const { return ArraySpan<const ObjectType>(m_Chunks[chunk], UsedInChunk(chunk)); }
+
+    ObjectType& operator[](uint32_t index)
+    {
+        CheckPolicy::Check(index < m_Size);
+        return *Address(index);
+    }
+
+    const ObjectType& operator[](uint32_t index) const
+    {
+        CheckPolicy::Check(index < m_Size);
+        return *Address(index);
+    }
+
+    ObjectType& First()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        return m_Chunks[0][0];
+    }
+
+    ObjectType& Last()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        return *Address(m_Size - 1);
+    }
+
+    // Allocates chunks until capacity elements fit. Existing elements stay where they are.
+    void Reserve(uint32_t capacity)
+    {
+        while (m_Capacity < capacity)
+            AddChunk();
+    }
+
+    void Push(const ObjectType& object) { Emplace(object); }
+    void Push(ObjectType&& object) { Emplace(std::move(object)); }
+
+    template<typename... Args>
+    ObjectType& Emplace(Args&&... args)
+    {
+        if (m_Size == m_Capacity)
+            AddChunk();
+        ObjectType* object = new (Address(m_Size)) ObjectType(std::forward<Args>(args)...);
+        ++m_Size;
+        return *object;
+    }
+
+    void Pop()
+    {
+        CheckPolicy::Check(m_Size > 0);
+        --m_Size;
+        Address(m_Size)->~ObjectType();
+    }
+
+    // Destroys the elements and keeps the chunks for reuse.
+    void Clear()
+    {
+        for (uint32_t chunk = 0; chunk < ChunkCount(); ++chunk)
+        {
+            ArraySpan<ObjectType> objects = Chunk(chunk);
+            ObjectRange<ObjectType>::Destroy(objects.begin(), objects.Size());
+        }
+        m_Size = 0;
+    }
+
+    // Frees the chunks past the last one in use.
+    void ShrinkToFit() { FreeChunks(ChunkCount()); }
+
+private:
+    ObjectType* Address(uint32_t index) const
+    {
+        uint32_t chunk;
+        uint32_t offset;
+        ChunkPolicy::Locate(index, chunk, offset);
+        return m_Chunks.Unchecked(chunk) + offset;
+    }
+
+    uint32_t UsedInChunk(uint32_t chunk) const
+    {
+        uint32_t lastChunk;
+        uint32_t lastOffset;
+        ChunkPolicy::Locate(m_Size - 1, lastChunk, lastOffset);
+        return chunk < lastChunk ? ChunkPolicy::ChunkSize(chunk) : lastOffset + 1;
+    }
+
+    // One past the last element, which is where an iterator stops.
+    ObjectType* EndPointer() const
+    {
+        if (m_Size == 0)
+            return nullptr;
+        return Address(m_Size - 1) + 1;
+    }
+
+    template<typename T>
+    IteratorT<T> MakeIterator() const
+    {
+        if (m_Size == 0)
+            return IteratorT<T>(nullptr, 0, nullptr, nullptr, nullptr);
+        ObjectType* first = m_Chunks[0];
+        return IteratorT<T>(m_Chunks.GetBuffer(), 0, first, first + ChunkPolicy::ChunkSize(0), EndPointer());
+    }
+
+    void AddChunk()
+    {
+        const uint32_t chunk = m_Chunks.Size();
+        const uint32_t chunkSize = ChunkPolicy::ChunkSize(chunk);
+        ASSERT(static_cast<uint64_t>(m_Capacity) + chunkSize < std::numeric_limits<uint32_t>::max());
+        ObjectType* data = GetAllocator().Allocate(chunkSize);
+        ASSERT(data != nullptr);
+        m_Chunks.Push(data);
+        m_Capacity += chunkSize;
+    }
+
+    // Frees chunks first and up, which must hold no elements.
+    void FreeChunks(uint32_t first)
+    {
+        while (m_Chunks.Size() > first)
+        {
+            m_Capacity -= ChunkPolicy::ChunkSize(m_Chunks.Size() - 1);
+            GetAllocator().Free(m_Chunks.Last());
+            m_Chunks.Pop();
+        }
+    }
+
+    BigArray<ObjectType*, typename TableRebind::Other> m_Chunks;
+    uint32_t m_Size;
+    uint32_t m_Capacity;
+};
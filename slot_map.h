@@ -0,0 +1,249 @@
+#pragma once
+#include "array.h"
+
+// Names an element of a SlotMap. The generation tells a handle to a removed element apart
+// from a handle to whatever later reused its slot. A default constructed handle never
+// names anything.
+struct SlotMapHandle
+{
+    enum : uint32_t { INVALID_INDEX = 0xFFFFFFFF };
+
+    SlotMapHandle() : m_Index(INVALID_INDEX), m_Generation(0) {}
+    SlotMapHandle(uint32_t index, uint32_t generation) : m_Index(index), m_Generation(generation) {}
+
+    bool operator==(const SlotMapHandle& other) const { return m_Index == other.m_Index && m_Generation == other.m_Generation; }
+    bool operator!=(const SlotMapHandle& other) const { return !(*this == other); }
+
+    uint32_t m_Index;
+    uint32_t m_Generation;
+};
+
+// Elements kept densely packed in a BigArray, like a swap-and-pop array, but reached
+// through handles that stay valid when other elements are removed. A handle indexes a
+// slot, and the slot holds the element's current position in the dense array; removal
+// moves the last element into the gap and repoints its slot. Insert, Remove and Find are
+// O(1), iteration walks the dense array, and nothing is allocated per element.
+//
+// Slots of removed elements are chained into a free list through the same field that
+// otherwise holds the dense position. A slot's generation is odd while it is in use and
+// is bumped on every insert and remove, so stale handles (even generation, or an older
+// odd one) fail to match. A slot can be reused 2^31 times before a handle could match
+// again.
+//
+// The Allocator argument is rebound for the slot arrays.
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, typename CheckPolicy = DefaultCheckPolicy>
+class SlotMap
+{
+    struct Slot
+    {
+        // Position in m_Values while in use, the next free slot otherwise.
+        uint32_t m_Dense;
+        uint32_t m_Generation;
+    };
+
+    typedef AllocatorRebind<Allocator, Slot> SlotRebind;
+    typedef AllocatorRebind<Allocator, uint32_t> IndexRebind;
+public:
+    typedef ObjectType* iterator;
+    typedef const ObjectType* const_iterator;
+    typedef ObjectType* Iterator;
+    typedef const ObjectType* ConstIterator;
+
+    SlotMap()
+        : SlotMap(Allocator())
+    {
+    }
+    explicit SlotMap(const Allocator& allocator)
+        : m_Values(allocator)
+        , m_Owners(IndexRebind::Convert(allocator))
+        , m_Slots(SlotRebind::Convert(allocator))
+        , m_FreeHead(END_OF_FREE_LIST)
+    {
+    }
+    SlotMap(const SlotMap& other) = default;
+    SlotMap(SlotMap&& other)
+        : m_Values(std::move(other.m_Values))
+        , m_Owners(std::move(other.m_Owners))
+        , m_Slots(std::move(other.m_Slots))
+        , m_FreeHead(other.m_FreeHead)
+    {
+        other.m_FreeHead = END_OF_FREE_LIST;
+    }
+
+    SlotMap& operator=(const SlotMap& other) = default;
+    SlotMap& operator=(SlotMap&& other)
+    {
+        if (this != &other)
+        {
+            SlotMap moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(SlotMap& other)
+    {
+        m_Values.Swap(other.m_Values);
+        m_Owners.Swap(other.m_Owners);
+        m_Slots.Swap(other.m_Slots);
+        std::swap(m_FreeHead, other.m_FreeHead);
+    }
+
+    const Allocator& GetAllocator() const { return m_Values.GetAllocator(); }
+
+    // The elements in dense order, which changes whenever one is removed.
+    Iterator begin() { return m_Values.begin(); }
+    Iterator end() { return m_Values.end(); }
+    ConstIterator begin() const { return m_Values.begin(); }
+    ConstIterator end() const { return m_Values.end(); }
+    ObjectType* GetBuffer() { return m_Values.GetBuffer(); }
+    const ObjectType* GetBuffer() const { return m_Values.GetBuffer(); }
+
+    uint32_t Size() const { return m_Values.Size(); }
+    bool Empty() const { return m_Values.Empty(); }
+
+    void Reserve(uint32_t capacity)
+    {
+        m_Values.Reserve(capacity);
+        m_Owners.Reserve(capacity);
+        m_Slots.Reserve(capacity);
+    }
+
+    // object may be an element of this map; it is then taken out of the way of the values
+    // growing before it is inserted.
+    SlotMapHandle Insert(const ObjectType& object)
+    {
+        if (!IsElement(object))
+            return Emplace(object);
+        ObjectType copy(object);
+        return Emplace(std::move(copy));
+    }
+
+    SlotMapHandle Insert(ObjectType&& object)
+    {
+        if (!IsElement(object))
+            return Emplace(std::move(object));
+        ObjectType moved(std::move(object));
+        return Emplace(std::move(moved));
+    }
+
+    // Constructs an element from args directly in the dense array. args must not refer to
+    // elements of this map, since growing may move them; Insert takes care of that.
+    template<typename... Args>
+    SlotMapHandle Emplace(Args&&... args)
+    {
+        m_Values.Emplace(std::forward<Args>(args)...);
+        uint32_t index = m_FreeHead;
+        if (index != END_OF_FREE_LIST)
+        {
+            m_FreeHead = m_Slots.Unchecked(index).m_Dense;
+        }
+        else
+        {
+            index = m_Slots.Size();
+            ASSERT(index != SlotMapHandle::INVALID_INDEX);
+            m_Slots.Push(Slot{0, 0});
+        }
+        Slot& slot = m_Slots.Unchecked(index);
+        slot.m_Dense = m_Owners.Size();
+        ++slot.m_Generation;
+        m_Owners.Push(index);
+        return SlotMapHandle(index, slot.m_Generation);
+    }
+
+    // The element handle names, or nullptr if it was removed.
+    ObjectType* Find(SlotMapHandle handle)
+    {
+        const uint32_t dense = DenseIndex(handle);
+        return dense == NOT_FOUND ? nullptr : &m_Values.Unchecked(dense);
+    }
+
+    const ObjectType* Find(SlotMapHandle handle) const
+    {
+        const uint32_t dense = DenseIndex(handle);
+        return dense == NOT_FOUND ? nullptr : &m_Values.Unchecked(dense);
+    }
+
+    bool Contains(SlotMapHandle handle) const { return DenseIndex(handle) != NOT_FOUND; }
+
+    // handle must name an element.
+    ObjectType& operator[](SlotMapHandle handle)
+    {
+        const uint32_t dense = DenseIndex(handle);
+        CheckPolicy::Check(dense != NOT_FOUND);
+        return m_Values.Unchecked(dense);
+    }
+
+    const ObjectType& operator[](SlotMapHandle handle) const
+    {
+        const uint32_t dense = DenseIndex(handle);
+        CheckPolicy::Check(dense != NOT_FOUND);
+        return m_Values.Unchecked(dense);
+    }
+
+    // The handle of the element at position dense of the iteration order.
+    SlotMapHandle HandleAt(uint32_t dense) const
+    {
+        const uint32_t index = m_Owners[dense];
+        return SlotMapHandle(index, m_Slots.Unchecked(index).m_Generation);
+    }
+
+    // Removes the element handle names, moving the last element into its place. Returns
+    // false if there was none.
+    bool Remove(SlotMapHandle handle)
+    {
+        const uint32_t dense = DenseIndex(handle);
+        if (dense == NOT_FOUND)
+            return false;
+        m_Values.RemoveAt(dense);
+        m_Owners.RemoveAt(dense);
+        if (dense < m_Owners.Size())
+            m_Slots.Unchecked(m_Owners.Unchecked(dense)).m_Dense = dense;
+        FreeSlot(handle.m_Index);
+        return true;
+    }
+
+    // Removes every element. Outstanding handles stop matching; the slots are kept for
+    // reuse.
+    void Clear()
+    {
+        for (uint32_t index : m_Owners)
+            FreeSlot(index);
+        m_Values.Clear();
+        m_Owners.Clear();
+    }
+
+private:
+    enum : uint32_t
+    {
+        END_OF_FREE_LIST = 0xFFFFFFFF,
+        NOT_FOUND = 0xFFFFFFFF,
+    };
+
+    bool IsElement(const ObjectType& object) const
+    {
+        return &object >= m_Values.GetBuffer() && &object < m_Values.GetBuffer() + m_Values.Size();
+    }
+
+    uint32_t DenseIndex(SlotMapHandle handle) const
+    {
+        if (handle.m_Index >= m_Slots.Size())
+            return NOT_FOUND;
+        const Slot& slot = m_Slots.Unchecked(handle.m_Index);
+        return slot.m_Generation == handle.m_Generation ? slot.m_Dense : NOT_FOUND;
+    }
+
+    void FreeSlot(uint32_t index)
+    {
+        Slot& slot = m_Slots.Unchecked(index);
+        ++slot.m_Generation;
+        slot.m_Dense = m_FreeHead;
+        m_FreeHead = index;
+    }
+
+    BigArray<ObjectType, Allocator, DefaultGrowthPolicy, CheckPolicy> m_Values;
+    // The slot of each element of m_Values, for repointing it when the element moves.
+    BigArray<uint32_t, typename IndexRebind::Other> m_Owners;
+    BigArray<Slot, typename SlotRebind::Other> m_Slots;
+    uint32_t m_FreeHead;
+};
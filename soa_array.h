@@ -0,0 +1,378 @@
+#pragma once
+#include "array.h"
+
+#include <tuple>
+
+// Compile-time list 0, 1, ..., N - 1, for expanding one statement per column.
+template<size_t... Indices>
+struct SoaIndices
+{
+};
+
+template<size_t N, size_t... Indices>
+struct MakeSoaIndices : MakeSoaIndices<N - 1, N - 1, Indices...>
+{
+};
+
+template<size_t... Indices>
+struct MakeSoaIndices<0, Indices...>
+{
+    typedef SoaIndices<Indices...> Type;
+};
+
+template<typename... Ts>
+struct SoaTriviallyRelocatable : std::true_type
+{
+};
+
+template<typename T, typename... Rest>
+struct SoaTriviallyRelocatable<T, Rest...>
+    : std::integral_constant<bool, IsTriviallyRelocatable<T>::value && SoaTriviallyRelocatable<Rest...>::value>
+{
+};
+
+// Parallel arrays of Ts... that share one size and one capacity. All columns live in a
+// single allocation, each starting on a COLUMN_ALIGNMENT boundary, so a Push checks for
+// growth once and a reallocation copies every column in one go. Column<I>() hands out a
+// column as a span for loops that should vectorize. Rows are removed the way
+// BaseArray::RemoveAt removes elements: the last row fills the hole unless preserve order
+// is set. The Allocator argument may be an allocator for any type; it is rebound to bytes.
+template<typename CountType, typename Allocator, typename... Ts>
+class SoaArray : private AllocatorStorage<typename AllocatorRebind<Allocator, uint8_t>::Other>
+{
+    static_assert(sizeof...(Ts) > 0, "SoaArray needs at least one column");
+    typedef AllocatorRebind<Allocator, uint8_t> ByteRebind;
+    typedef typename ByteRebind::Other ByteAllocator;
+    typedef AllocatorStorage<ByteAllocator> AllocatorBase;
+    typedef typename MakeSoaIndices<sizeof...(Ts)>::Type Columns;
+public:
+    enum : size_t
+    {
+        COLUMN_COUNT = sizeof...(Ts),
+        COLUMN_ALIGNMENT = 64,
+    };
+
+    template<size_t I>
+    using ColumnType = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+    SoaArray()
+        : SoaArray(Allocator())
+    {
+    }
+    explicit SoaArray(const Allocator& allocator)
+        : AllocatorBase(ByteRebind::Convert(allocator))
+        , m_Block(nullptr)
+        , m_Size(0)
+        , m_Capacity(0)
+        , m_PreserveOrder(false)
+    {
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            m_Offsets[i] = 0;
+    }
+    SoaArray(const SoaArray& other)
+        : AllocatorBase(other.GetAllocator())
+        , m_Block(nullptr)
+        , m_Size(0)
+        , m_Capacity(0)
+        , m_PreserveOrder(other.m_PreserveOrder)
+    {
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            m_Offsets[i] = 0;
+        Reserve(other.m_Size);
+        CopyRows(other, Columns());
+        m_Size = other.m_Size;
+    }
+    SoaArray(SoaArray&& other)
+        : AllocatorBase(other.GetAllocator())
+        , m_Block(other.m_Block)
+        , m_Size(other.m_Size)
+        , m_Capacity(other.m_Capacity)
+        , m_PreserveOrder(other.m_PreserveOrder)
+    {
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+        {
+            m_Offsets[i] = other.m_Offsets[i];
+            other.m_Offsets[i] = 0;
+        }
+        other.m_Block = nullptr;
+        other.m_Size = 0;
+        other.m_Capacity = 0;
+    }
+
+    ~SoaArray()
+    {
+        Clear();
+        GetAllocator().Free(m_Block);
+    }
+
+    SoaArray& operator=(const SoaArray& other)
+    {
+        if (this != &other)
+        {
+            SoaArray copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SoaArray& operator=(SoaArray&& other)
+    {
+        if (this != &other)
+        {
+            SoaArray moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(SoaArray& other)
+    {
+        std::swap(GetAllocator(), other.GetAllocator());
+        std::swap(m_Block, other.m_Block);
+        std::swap(m_Size, other.m_Size);
+        std::swap(m_Capacity, other.m_Capacity);
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            std::swap(m_Offsets[i], other.m_Offsets[i]);
+        const bool preserveOrder = m_PreserveOrder;
+        m_PreserveOrder = other.m_PreserveOrder;
+        other.m_PreserveOrder = preserveOrder;
+    }
+
+    ByteAllocator& GetAllocator() { return AllocatorBase::GetAllocator(); }
+    const ByteAllocator& GetAllocator() const { return AllocatorBase::GetAllocator(); }
+
+    CountType Size() const { return m_Size; }
+    CountType Capacity() const { return m_Capacity; }
+    bool Empty() const { return m_Size == 0; }
+
+    void Reserve(CountType capacity)
+    {
+        if (capacity > m_Capacity)
+            Reallocate(capacity);
+    }
+
+    void Clear()
+    {
+        DestroyRows(0, m_Size, Columns());
+        m_Size = 0;
+    }
+
+    // The Ith column, from row 0 to Size(). Valid until the array reallocates.
+    template<size_t I>
+    ArraySpan<ColumnType<I>> Column() { return ArraySpan<ColumnType<I>>(ColumnData<I>(), m_Size); }
+
+    template<size_t I>
+    ArraySpan<const ColumnType<I>> Column() const { return ArraySpan<const ColumnType<I>>(ColumnData<I>(), m_Size); }
+
+    template<size_t I>
+    ColumnType<I>& Get(CountType index)
+    {
+        DefaultCheckPolicy::Check(index < m_Size);
+        return ColumnData<I>()[index];
+    }
+
+    template<size_t I>
+    const ColumnType<I>& Get(CountType index) const
+    {
+        DefaultCheckPolicy::Check(index < m_Size);
+        return ColumnData<I>()[index];
+    }
+
+    // Appends a row, constructing column i from values[i]. The values must not refer to
+    // elements of this array, since growing may move them.
+    template<typename... Args>
+    void Push(Args&&... values)
+    {
+        static_assert(sizeof...(Args) == COLUMN_COUNT, "Push takes one value per column");
+        GrowTo(static_cast<size_t>(m_Size) + 1);
+        ConstructRow(m_Size, Columns(), std::forward<Args>(values)...);
+        ++m_Size;
+    }
+
+    void Pop()
+    {
+        DefaultCheckPolicy::Check(m_Size > 0);
+        --m_Size;
+        DestroyRows(m_Size, 1, Columns());
+    }
+
+    void RemoveAt(CountType index)
+    {
+        DefaultCheckPolicy::Check(index < m_Size);
+        --m_Size;
+        RemoveRow(index, Columns());
+    }
+
+    bool GetPreserveOrder() const { return m_PreserveOrder; }
+    void SetPreserveOrder(bool preserve) { m_PreserveOrder = preserve; }
+
+private:
+    template<size_t I>
+    ColumnType<I>* ColumnData() const { return reinterpret_cast<ColumnType<I>*>(m_Block + m_Offsets[I]); }
+
+    static size_t AlignUp(size_t offset) { return (offset + COLUMN_ALIGNMENT - 1) & ~static_cast<size_t>(COLUMN_ALIGNMENT - 1); }
+
+    // Bytes from the first column to the end of the last for capacity rows.
+    static size_t ColumnBytes(CountType capacity)
+    {
+        static const size_t sizes[] = { sizeof(Ts)... };
+        size_t offset = 0;
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            offset = AlignUp(offset) + sizes[i] * capacity;
+        return offset;
+    }
+
+    // Offsets of the columns of capacity rows from the start of block.
+    static void Partition(const uint8_t* block, CountType capacity, uint32_t* offsets)
+    {
+        static const size_t sizes[] = { sizeof(Ts)... };
+        const size_t slack = AlignUp(reinterpret_cast<uintptr_t>(block)) - reinterpret_cast<uintptr_t>(block);
+        size_t offset = 0;
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+        {
+            offset = AlignUp(offset);
+            offsets[i] = static_cast<uint32_t>(slack + offset);
+            offset += sizes[i] * capacity;
+        }
+    }
+
+    void GrowTo(size_t required)
+    {
+        if (required <= m_Capacity)
+            return;
+        static const size_t rowBytes = ColumnBytes(1);
+        const size_t maxCapacity = static_cast<size_t>(std::numeric_limits<CountType>::max()) - 1;
+        ASSERT(required <= maxCapacity);
+        size_t newCapacity = DefaultGrowthPolicy::NextCapacity(m_Capacity, required, rowBytes);
+        if (newCapacity > maxCapacity)
+            newCapacity = maxCapacity;
+        Reallocate(static_cast<CountType>(newCapacity));
+    }
+
+    // Moves every column into a block of capacity rows. When the columns can be moved with
+    // memcpy and the allocator can reallocate, the block itself is reallocated, which for
+    // large blocks remaps its pages rather than copying them, and the columns are then
+    // slid to their new offsets.
+    void Reallocate(CountType capacity)
+    {
+        ASSERT(capacity >= m_Size);
+        typedef std::integral_constant<bool, SoaTriviallyRelocatable<Ts...>::value
+            && AllocatorTraits<ByteAllocator, uint8_t>::HasReallocate::value> InPlace;
+        Reallocate(capacity, InPlace());
+    }
+
+    // Room to align the first column, as allocators only promise alignof(uint8_t).
+    static uint32_t BlockBytes(CountType capacity)
+    {
+        const size_t bytes = ColumnBytes(capacity) + COLUMN_ALIGNMENT - 1;
+        ASSERT(bytes <= std::numeric_limits<uint32_t>::max());
+        return static_cast<uint32_t>(bytes);
+    }
+
+    void Reallocate(CountType capacity, std::false_type)
+    {
+        uint8_t* block = GetAllocator().Allocate(BlockBytes(capacity));
+        ASSERT(block != nullptr);
+        uint32_t offsets[COLUMN_COUNT];
+        Partition(block, capacity, offsets);
+        RelocateRows(block, offsets, Columns());
+        GetAllocator().Free(m_Block);
+        SetBlock(block, offsets, capacity);
+    }
+
+    void Reallocate(CountType capacity, std::true_type)
+    {
+        if (m_Block == nullptr)
+        {
+            Reallocate(capacity, std::false_type());
+            return;
+        }
+        // The columns are kept as offsets, so nothing refers to the old block once it is
+        // reallocated.
+        uint8_t* block = AllocatorTraits<ByteAllocator, uint8_t>::Reallocate(GetAllocator(), m_Block, BlockBytes(m_Capacity), BlockBytes(capacity));
+        ASSERT(block != nullptr);
+        uint32_t offsets[COLUMN_COUNT];
+        Partition(block, capacity, offsets);
+        // Columns moving down go first, in order, then those moving up, in reverse order, so
+        // no column lands on data that hasn't moved yet.
+        static const size_t sizes[] = { sizeof(Ts)... };
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+        {
+            if (offsets[i] <= m_Offsets[i])
+                memmove(block + offsets[i], block + m_Offsets[i], sizes[i] * m_Size);
+        }
+        for (size_t i = COLUMN_COUNT; i-- > 0;)
+        {
+            if (offsets[i] > m_Offsets[i])
+                memmove(block + offsets[i], block + m_Offsets[i], sizes[i] * m_Size);
+        }
+        SetBlock(block, offsets, capacity);
+    }
+
+    void SetBlock(uint8_t* block, const uint32_t* offsets, CountType capacity)
+    {
+        m_Block = block;
+        for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            m_Offsets[i] = offsets[i];
+        m_Capacity = capacity;
+    }
+
+    // One statement per column, expanded over the index list.
+    template<size_t... Is, typename... Args>
+    void ConstructRow(CountType index, SoaIndices<Is...>, Args&&... values)
+    {
+        int expand[] = { 0, (new (&ColumnData<Is>()[index]) ColumnType<Is>(std::forward<Args>(values)), 0)... };
+        (void)expand;
+    }
+
+    template<size_t... Is>
+    void RelocateRows(uint8_t* block, const uint32_t* offsets, SoaIndices<Is...>)
+    {
+        int expand[] = { 0, (ObjectRange<ColumnType<Is>>::Relocate(reinterpret_cast<ColumnType<Is>*>(block + offsets[Is]), ColumnData<Is>(), m_Size), 0)... };
+        (void)expand;
+    }
+
+    template<size_t... Is>
+    void CopyRows(const SoaArray& other, SoaIndices<Is...>)
+    {
+        int expand[] = { 0, (ObjectRange<ColumnType<Is>>::Copy(ColumnData<Is>(), other.template ColumnData<Is>(), other.m_Size), 0)... };
+        (void)expand;
+    }
+
+    template<size_t... Is>
+    void DestroyRows(CountType first, CountType count, SoaIndices<Is...>)
+    {
+        int expand[] = { 0, (ObjectRange<ColumnType<Is>>::Destroy(ColumnData<Is>() + first, count), 0)... };
+        (void)expand;
+    }
+
+    // Removes row index from every column; m_Size is already the new size.
+    template<size_t... Is>
+    void RemoveRow(CountType index, SoaIndices<Is...>)
+    {
+        int expand[] = { 0, (RemoveFromColumn(ColumnData<Is>(), index), 0)... };
+        (void)expand;
+    }
+
+    template<typename T>
+    void RemoveFromColumn(T* data, CountType index)
+    {
+        data[index].~T();
+        if (index == m_Size)
+            return;
+        if (m_PreserveOrder)
+            ObjectRange<T>::Relocate(&data[index], &data[index + 1], m_Size - index);
+        else
+            ObjectRange<T>::Relocate(&data[index], &data[m_Size], 1);
+    }
+
+    uint8_t* m_Block;
+    // Where each column starts in m_Block.
+    uint32_t m_Offsets[COLUMN_COUNT];
+    CountType m_Size;
+    CountType m_Capacity;
+    bool m_PreserveOrder;
+};
+
+template<typename... Ts>
+using BigSoaArray = SoaArray<uint32_t, DefaultAllocatorT<uint8_t>, Ts...>;
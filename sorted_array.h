@@ -0,0 +1,260 @@
+#pragma once
+#include "array.h"
+
+#include <functional>
+
+// A set of unique elements kept in ascending order in BigArray storage. Lookups are binary
+// searches, Insert and Remove shift the tail once, and Merge adds a whole sorted batch in
+// a single O(n + k) pass instead of k shifting inserts.
+//
+// For read-mostly sets BuildSearchLayout keeps a second copy of the elements in Eytzinger
+// (breadth-first) order. Contains then walks the tree top-down, so the first levels share a
+// handful of cache lines that stay hot across lookups and the lines further down can be
+// prefetched ahead of the comparisons. The copy is dropped by every mutation and has to be
+// rebuilt afterwards.
+template<typename ObjectType, typename Less = std::less<ObjectType>, typename Allocator = DefaultAllocatorT<ObjectType>, typename GrowthPolicy = DefaultGrowthPolicy, typename CheckPolicy = DefaultCheckPolicy>
+class SortedArray : private BigArray<ObjectType, Allocator, GrowthPolicy, CheckPolicy>
+{
+    typedef BigArray<ObjectType, Allocator, GrowthPolicy, CheckPolicy> super;
+public:
+    typedef const ObjectType* const_iterator;
+    typedef const ObjectType* ConstIterator;
+
+    SortedArray()
+        : SortedArray(Less())
+    {
+    }
+    explicit SortedArray(const Less& less, const Allocator& allocator = Allocator())
+        : super(allocator)
+        , m_Layout(allocator)
+        , m_LayoutOffset(0)
+        , m_LayoutSize(0)
+        , m_Less(less)
+    {
+    }
+
+    using super::Size;
+    using super::Capacity;
+    using super::Reserve;
+    using super::ShrinkToFit;
+    using super::Empty;
+    using super::GetAllocator;
+
+    ConstIterator begin() const { return super::begin(); }
+    ConstIterator end() const { return super::end(); }
+    const ObjectType& operator[](uint32_t index) const { return super::operator[](index); }
+    const ObjectType* GetBuffer() const { return super::GetBuffer(); }
+
+    void Clear()
+    {
+        super::Clear();
+        m_Layout.Clear();
+    }
+
+    // Index of the first element not ordered before value, or Size() if there is none.
+    uint32_t LowerBound(const ObjectType& value) const
+    {
+        const ObjectType* data = this->m_Data;
+        const ObjectType* base = data;
+        uint32_t count = this->m_Size;
+        if (count == 0)
+            return 0;
+        // Branchless: the loop runs log2(n) times whatever the comparisons return, and
+        // both halves the next step could probe are prefetched.
+        while (count > 1)
+        {
+            const uint32_t half = count / 2;
+            __builtin_prefetch(base + half / 2);
+            __builtin_prefetch(base + half + half / 2);
+            base = m_Less(base[half], value) ? base + half : base;
+            count -= half;
+        }
+        return static_cast<uint32_t>(base - data) + (m_Less(*base, value) ? 1 : 0);
+    }
+
+    const ObjectType* Find(const ObjectType& value) const
+    {
+        const uint32_t index = LowerBound(value);
+        if (index == this->m_Size || m_Less(value, this->m_Data[index]))
+            return nullptr;
+        return &this->m_Data[index];
+    }
+
+    bool Contains(const ObjectType& value) const
+    {
+        if (!m_Layout.Empty())
+            return LayoutContains(value);
+        return Find(value) != nullptr;
+    }
+
+    // Adds value unless an equivalent element is already present. Returns whether it was
+    // added.
+    bool Insert(const ObjectType& value)
+    {
+        const uint32_t index = LowerBound(value);
+        if (index < this->m_Size && !m_Less(value, this->m_Data[index]))
+            return false;
+        super::Insert(index, value);
+        m_Layout.Clear();
+        return true;
+    }
+
+    bool Insert(ObjectType&& value)
+    {
+        const uint32_t index = LowerBound(value);
+        if (index < this->m_Size && !m_Less(value, this->m_Data[index]))
+            return false;
+        super::Insert(index, std::move(value));
+        m_Layout.Clear();
+        return true;
+    }
+
+    bool Remove(const ObjectType& value)
+    {
+        const uint32_t index = LowerBound(value);
+        if (index == this->m_Size || m_Less(value, this->m_Data[index]))
+            return false;
+        RemoveAt(index);
+        return true;
+    }
+
+    // Always slides the tail down, whatever the preserve order flag of the storage says.
+    void RemoveAt(uint32_t index)
+    {
+        CheckPolicy::Check(index < this->m_Size);
+        this->m_Data[index].~ObjectType();
+        --this->m_Size;
+        super::RelocateRange(&this->m_Data[index], &this->m_Data[index + 1], this->m_Size - index);
+        m_Layout.Clear();
+    }
+
+    // Adds the count elements at sorted, which must be in ascending order and must not
+    // point into this array. Elements already present, and repeats within the batch, are
+    // skipped. Grows at most once and moves every existing element at most once.
+    void Merge(const ObjectType* sorted, uint32_t count)
+    {
+        const uint32_t oldSize = this->m_Size;
+        const uint32_t added = CountNew(sorted, count);
+        if (added == 0)
+            return;
+        this->GrowTo(static_cast<size_t>(oldSize) + added);
+        ObjectType* data = this->m_Data;
+        // Fill from the back, so existing elements only move into slots that are already
+        // free. Once every new element is placed the remaining prefix is where it belongs.
+        uint32_t read = oldSize;
+        uint32_t write = oldSize + added;
+        uint32_t next = count;
+        while (write > read)
+        {
+            const ObjectType& candidate = sorted[next - 1];
+            if (next > 1 && !m_Less(sorted[next - 2], candidate))
+            {
+                --next;
+            }
+            else if (read > 0 && m_Less(candidate, data[read - 1]))
+            {
+                super::RelocateRange(&data[--write], &data[--read], 1);
+            }
+            else if (read > 0 && !m_Less(data[read - 1], candidate))
+            {
+                --next;
+            }
+            else
+            {
+                new (&data[--write]) ObjectType(candidate);
+                --next;
+            }
+        }
+        this->m_Size = oldSize + added;
+        m_Layout.Clear();
+    }
+
+    template<typename OtherCountType, typename OtherAllocator, typename OtherGrowthPolicy, typename OtherCheckPolicy, bool OtherIsCopyable>
+    void Merge(const BaseArray<OtherCountType, ObjectType, OtherAllocator, OtherGrowthPolicy, OtherCheckPolicy, OtherIsCopyable>& sorted)
+    {
+        Merge(sorted.GetBuffer(), static_cast<uint32_t>(sorted.Size()));
+    }
+
+    // Builds the Eytzinger copy used by Contains. Worth it once the set outgrows the
+    // caches and is searched far more often than it changes; requires a default
+    // constructible element type.
+    void BuildSearchLayout()
+    {
+        m_Layout.Clear();
+        if (this->m_Size == 0)
+            return;
+        m_Layout.Resize(this->m_Size + PREFETCH_STRIDE);
+        // Skew the start so that node k * PREFETCH_STRIDE, the first of the nodes prefetched
+        // at node k, begins a cache line.
+        const uintptr_t address = reinterpret_cast<uintptr_t>(m_Layout.GetBuffer());
+        m_LayoutOffset = static_cast<uint32_t>(((64 - address % 64) % 64) / sizeof(ObjectType));
+        m_LayoutSize = this->m_Size;
+        uint32_t next = 0;
+        FillLayout(next, 1);
+    }
+
+    // Frees the Eytzinger copy, which mutations only empty.
+    void DropSearchLayout()
+    {
+        m_Layout.Clear();
+        m_Layout.ShrinkToFit();
+    }
+
+    bool HasSearchLayout() const { return !m_Layout.Empty(); }
+
+private:
+    // Nodes per cache line, which is also the distance between a node and its first
+    // descendant four levels down for 4 byte elements.
+    enum : size_t { PREFETCH_STRIDE = sizeof(ObjectType) >= 64 ? 1 : 64 / sizeof(ObjectType) };
+
+    // Number of elements of the sorted batch that Merge would add.
+    uint32_t CountNew(const ObjectType* sorted, uint32_t count) const
+    {
+        const ObjectType* data = this->m_Data;
+        const uint32_t size = this->m_Size;
+        uint32_t added = 0;
+        uint32_t read = 0;
+        for (uint32_t next = 0; next < count; ++next)
+        {
+            if (next > 0 && !m_Less(sorted[next - 1], sorted[next]))
+                continue;
+            while (read < size && m_Less(data[read], sorted[next]))
+                ++read;
+            if (read == size || m_Less(sorted[next], data[read]))
+                ++added;
+        }
+        return added;
+    }
+
+    // Node k of the implicit tree lives at m_Layout[m_LayoutOffset + k] and has children 2k
+    // and 2k + 1. An in-order walk hands out the sorted elements in order.
+    void FillLayout(uint32_t& next, size_t node)
+    {
+        if (node > m_LayoutSize)
+            return;
+        FillLayout(next, 2 * node);
+        m_Layout.Unchecked(static_cast<uint32_t>(node + m_LayoutOffset)) = this->m_Data[next++];
+        FillLayout(next, 2 * node + 1);
+    }
+
+    bool LayoutContains(const ObjectType& value) const
+    {
+        const ObjectType* layout = m_Layout.GetBuffer() + m_LayoutOffset;
+        const size_t size = m_LayoutSize;
+        size_t node = 1;
+        while (node <= size)
+        {
+            __builtin_prefetch(layout + node * PREFETCH_STRIDE);
+            node = 2 * node + (m_Less(layout[node], value) ? 1 : 0);
+        }
+        // The path went right at every node ordered before value; dropping those trailing
+        // steps and the final left one leaves the lower bound, or 0 if there is none.
+        node >>= __builtin_ffsll(static_cast<long long>(~node));
+        return node != 0 && !m_Less(value, layout[node]);
+    }
+
+    super m_Layout;
+    uint32_t m_LayoutOffset;
+    uint32_t m_LayoutSize;
+    Less m_Less;
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include "array.h"
+
+#include <string.h>
+
+// Maps integer ids to values kept densely packed in a BigArray, for id spaces far larger
+// than the number of ids in use. The sparse side is an array of dense positions indexed by
+// id, split into pages of 2^PAGE_SHIFT entries that are only allocated once an id in
+// their range is inserted, so ten thousand live ids out of fifty million cost a few pages
+// rather than 200MB. Insert, Remove, Contains and Find are two dependent loads and no
+// hashing; iteration walks the dense ids and values; removal swaps the last element into
+// the gap.
+//
+// Pages are allocated and freed through the Allocator argument rebound to uint32_t, and
+// are kept until the set is destroyed.
+template<typename ObjectType, typename Allocator = DefaultAllocatorT<ObjectType>, uint32_t PAGE_SHIFT = 12, typename CheckPolicy = DefaultCheckPolicy>
+class SparseSet
+{
+    static_assert(PAGE_SHIFT > 0 && PAGE_SHIFT < 32, "Pages must hold between 2 and 2^31 entries");
+
+    typedef AllocatorRebind<Allocator, uint32_t> IdRebind;
+    typedef AllocatorRebind<Allocator, uint32_t*> PageRebind;
+public:
+    typedef ObjectType* iterator;
+    typedef const ObjectType* const_iterator;
+    typedef ObjectType* Iterator;
+    typedef const ObjectType* ConstIterator;
+
+    enum : uint32_t { PAGE_SIZE = 1u << PAGE_SHIFT };
+
+    SparseSet()
+        : SparseSet(Allocator())
+    {
+    }
+    explicit SparseSet(const Allocator& allocator)
+        : m_Values(allocator)
+        , m_Ids(IdRebind::Convert(allocator))
+        , m_Pages(PageRebind::Convert(allocator))
+    {
+    }
+    SparseSet(const SparseSet& other)
+        : m_Values(other.m_Values)
+        , m_Ids(other.m_Ids)
+        , m_Pages(PageRebind::Convert(other.GetAllocator()))
+    {
+        m_Pages.ResizeZeroed(other.m_Pages.Size());
+        for (uint32_t page = 0; page < m_Pages.Size(); ++page)
+        {
+            if (other.m_Pages[page] != nullptr)
+                memcpy(AllocatePage(page), other.m_Pages[page], PAGE_SIZE * sizeof(uint32_t));
+        }
+    }
+    SparseSet(SparseSet&& other) = default;
+
+    ~SparseSet()
+    {
+        FreePages();
+    }
+
+    SparseSet& operator=(const SparseSet& other)
+    {
+        if (this != &other)
+        {
+            SparseSet copy(other);
+            Swap(copy);
+        }
+        return *this;
+    }
+
+    SparseSet& operator=(SparseSet&& other)
+    {
+        if (this != &other)
+        {
+            SparseSet moved(std::move(other));
+            Swap(moved);
+        }
+        return *this;
+    }
+
+    void Swap(SparseSet& other)
+    {
+        m_Values.Swap(other.m_Values);
+        m_Ids.Swap(other.m_Ids);
+        m_Pages.Swap(other.m_Pages);
+    }
+
+    const Allocator& GetAllocator() const { return m_Values.GetAllocator(); }
+
+    // The values in dense order, which changes whenever one is removed. Ids() lists the
+    // id of each.
+    Iterator begin() { return m_Values.begin(); }
+    Iterator end() { return m_Values.end(); }
+    ConstIterator begin() const { return m_Values.begin(); }
+    ConstIterator end() const { return m_Values.end(); }
+    ArraySpan<const uint32_t> Ids() const { return ArraySpan<const uint32_t>(m_Ids.GetBuffer(), m_Ids.Size()); }
+    ArraySpan<ObjectType> Values() { return ArraySpan<ObjectType>(m_Values.GetBuffer(), m_Values.Size()); }
+    ArraySpan<const ObjectType> Values() const { return ArraySpan<const ObjectType>(m_Values.GetBuffer(), m_Values.Size()); }
+
+    uint32_t Size() const { return m_Values.Size(); }
+    bool Empty() const { return m_Values.Empty(); }
+
+    // Reserves dense storage; pages are still allocated as ids arrive.
+    void Reserve(uint32_t count)
+    {
+        m_Values.Reserve(count);
+        m_Ids.Reserve(count);
+    }
+
+    bool Contains(uint32_t id) const { return DenseIndex(id) != NOT_FOUND; }
+
+    ObjectType* Find(uint32_t id)
+    {
+        const uint32_t dense = DenseIndex(id);
+        return dense == NOT_FOUND ? nullptr : &m_Values.Unchecked(dense);
+    }
+
+    const ObjectType* Find(uint32_t id) const
+    {
+        const uint32_t dense = DenseIndex(id);
+        return dense == NOT_FOUND ? nullptr : &m_Values.Unchecked(dense);
+    }
+
+    // Adds id with a value constructed from args unless id is already present. Returns
+    // whether it was added.
+    template<typename... Args>
+    bool Emplace(uint32_t id, Args&&... args)
+    {
+        uint32_t& entry = Entry(id);
+        if (entry != NOT_FOUND)
+            return false;
+        m_Values.Emplace(std::forward<Args>(args)...);
+        entry = m_Ids.Size();
+        m_Ids.Push(id);
+        return true;
+    }
+
+    bool Insert(uint32_t id, const ObjectType& value) { return Emplace(id, value); }
+    bool Insert(uint32_t id, ObjectType&& value) { return Emplace(id, std::move(value)); }
+
+    // The value for id, default constructed first if id is not present.
+    ObjectType& operator[](uint32_t id)
+    {
+        uint32_t& entry = Entry(id);
+        if (entry == NOT_FOUND)
+        {
+            m_Values.Emplace();
+            entry = m_Ids.Size();
+            m_Ids.Push(id);
+        }
+        return m_Values.Unchecked(entry);
+    }
+
+    bool Remove(uint32_t id)
+    {
+        const uint32_t dense = DenseIndex(id);
+        if (dense == NOT_FOUND)
+            return false;
+        m_Values.RemoveAt(dense);
+        m_Ids.RemoveAt(dense);
+        if (dense < m_Ids.Size())
+            m_Pages.Unchecked(m_Ids.Unchecked(dense) >> PAGE_SHIFT)[m_Ids.Unchecked(dense) & (PAGE_SIZE - 1)] = dense;
+        m_Pages.Unchecked(id >> PAGE_SHIFT)[id & (PAGE_SIZE - 1)] = NOT_FOUND;
+        return true;
+    }
+
+    // Removes every element and keeps the pages.
+    void Clear()
+    {
+        for (uint32_t id : m_Ids)
+            m_Pages.Unchecked(id >> PAGE_SHIFT)[id & (PAGE_SIZE - 1)] = NOT_FOUND;
+        m_Values.Clear();
+        m_Ids.Clear();
+    }
+
+    // Calls function(id, value, otherValue) for every id present in both sets. Walks the
+    // smaller set densely and looks each id up in the larger one, so the cost is
+    // proportional to the smaller set.
+    template<typename OtherSet, typename Function>
+    void Intersect(OtherSet& other, Function function)
+    {
+        if (Size() <= other.Size())
+        {
+            for (uint32_t i = 0; i < m_Ids.Size(); ++i)
+            {
+                auto otherValue = other.Find(m_Ids.Unchecked(i));
+                if (otherValue != nullptr)
+                    function(m_Ids.Unchecked(i), m_Values.Unchecked(i), *otherValue);
+            }
+        }
+        else
+        {
+            const ArraySpan<const uint32_t> otherIds = other.Ids();
+            auto otherValues = other.Values();
+            for (size_t i = 0; i < otherIds.Size(); ++i)
+            {
+                ObjectType* value = Find(otherIds[i]);
+                if (value != nullptr)
+                    function(otherIds[i], *value, otherValues[i]);
+            }
+        }
+    }
+
+    // Number of pages allocated.
+    uint32_t PageCount() const
+    {
+        uint32_t count = 0;
+        for (const uint32_t* page : m_Pages)
+            count += page != nullptr ? 1 : 0;
+        return count;
+    }
+
+private:
+    enum : uint32_t { NOT_FOUND = 0xFFFFFFFF };
+
+    uint32_t DenseIndex(uint32_t id) const
+    {
+        const uint32_t page = id >> PAGE_SHIFT;
+        if (page >= m_Pages.Size() || m_Pages.Unchecked(page) == nullptr)
+            return NOT_FOUND;
+        return m_Pages.Unchecked(page)[id & (PAGE_SIZE - 1)];
+    }
+
+    // The sparse entry for id, allocating its page if needed.
+    uint32_t& Entry(uint32_t id)
+    {
+        const uint32_t page = id >> PAGE_SHIFT;
+        if (page >= m_Pages.Size())
+            m_Pages.ResizeZeroed(page + 1);
+        uint32_t* entries = m_Pages.Unchecked(page);
+        if (entries == nullptr)
+        {
+            entries = AllocatePage(page);
+            memset(entries, 0xFF, PAGE_SIZE * sizeof(uint32_t));
+        }
+        return entries[id & (PAGE_SIZE - 1)];
+    }
+
+    uint32_t* AllocatePage(uint32_t page)
+    {
+        uint32_t* entries = m_Ids.GetAllocator().Allocate(PAGE_SIZE);
+        ASSERT(entries != nullptr);
+        m_Pages.Unchecked(page) = entries;
+        return entries;
+    }
+
+    void FreePages()
+    {
+        for (uint32_t* page : m_Pages)
+        {
+            if (page != nullptr)
+                m_Ids.GetAllocator().Free(page);
+        }
+        m_Pages.Clear();
+    }
+
+    BigArray<ObjectType, Allocator, DefaultGrowthPolicy, CheckPolicy> m_Values;
+    BigArray<uint32_t, typename IdRebind::Other> m_Ids;
+    BigArray<uint32_t*, typename PageRebind::Other> m_Pages;
+};